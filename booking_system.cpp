@@ -6,9 +6,14 @@
 #include <random>
 #include <chrono>
 #include <sstream>
+#include <fstream>
+#include <cstdio>
+#include "network_loader.hpp"
+#include "timetable.hpp"
+#include "local_socket.hpp"
 using namespace std;
 
-struct Airport {
+struct AirportListing {
     std::string code;
     std::string name;
 };
@@ -62,6 +67,7 @@ struct FlightTicket {
     std::string departureDate;
     std::string departureTime;
     std::string arrivalTime;
+    std::string itinerary;
     double price;
     std::string passengerName;
     std::string seatNumber;
@@ -69,54 +75,6 @@ struct FlightTicket {
     bool isBooked;
 };
 
-std::string generateRandomTime() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> hour_dist(0, 23);
-    std::uniform_int_distribution<> minute_dist(0, 59);
-    
-    int hour = hour_dist(gen);
-    int minute = minute_dist(gen);
-    
-    std::stringstream ss;
-    ss << std::setfill('0') << std::setw(2) << hour << ":"
-       << std::setfill('0') << std::setw(2) << minute;
-    
-    return ss.str();
-}
-
-std::pair<std::string, std::string> generateFlightTimes(double distance) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    
-    std::string departureTime = generateRandomTime();
-    
-    int durationHours = static_cast<int>(distance / 100) + 1;
-    std::uniform_int_distribution<> minute_dist(0, 59);
-    int durationMinutes = minute_dist(gen);
-    
-    int depHour, depMinute;
-    sscanf(departureTime.c_str(), "%d:%d", &depHour, &depMinute);
-    
-    int arrHour = depHour + durationHours;
-    int arrMinute = depMinute + durationMinutes;
-   
-    if (arrMinute >= 60) {
-        arrHour += 1;
-        arrMinute -= 60;
-    }
-    
-    if (arrHour >= 24) {
-        arrHour -= 24;
-    }
-    
-    std::stringstream ss;
-    ss << std::setfill('0') << std::setw(2) << arrHour << ":"
-       << std::setfill('0') << std::setw(2) << arrMinute;
-    
-    return {departureTime, ss.str()};
-}
-
 double generateRandomPrice(double distance) {
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -167,63 +125,96 @@ void printLine(char c = '-', int length = 50) {
     std::cout << std::endl;
 }
 
-FlightTicket bookFlight(const std::vector<Airport>& airports, int src, int dst) {
+// Minutes since local midnight.
+int currentMinuteOfDay() {
+    std::time_t now_time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm* now_tm = std::localtime(&now_time);
+    return now_tm->tm_hour * 60 + now_tm->tm_min;
+}
 
-    double distance = 500 + (src * 100) + (dst * 50); 
-    
+// Lists the itineraries from src to dst still leaving today (every
+// departure from now on that no later departure beats, from a profile
+// query on the timetable) and books the one selected. The ticket is not
+// booked if there are none.
+FlightTicket bookFlight(const std::vector<AirportListing>& airports, const FlightGraph& network,
+                        const Timetable& timetable, int src, int dst) {
     Date currentDate = Date::getCurrentDate();
    
     std::vector<FlightTicket> flightOptions;
+    std::vector<ProfileEntry> profile;
+    timetable.profile(src, dst, currentMinuteOfDay(), 1439, profile);
    
     printLine('=');
     std::cout << "AVAILABLE FLIGHTS" << std::endl;
     printLine('=');
     std::cout << "From: " << airports[src].code << " To: " << airports[dst].code << std::endl << std::endl;
+    if (profile.empty()) {
+        std::cout << "No scheduled flights connect " << airports[src].code << " to " << airports[dst].code
+                  << " for the rest of today." << std::endl;
+        FlightTicket none;
+        none.isBooked = false;
+        return none;
+    }
     std::cout << std::left << std::setw(5) << "No." 
               << std::setw(12) << "Date" 
               << std::setw(12) << "Departure" 
               << std::setw(12) << "Arrival" 
+              << std::setw(8) << "Stops" 
               << std::setw(10) << "Price" 
               << std::endl;
     printLine();
     
-    for (int i = 0; i < 5; ++i) {
-        Date flightDate = currentDate.addDays(i);
-        auto [departureTime, arrivalTime] = generateFlightTimes(distance);
-        double price = generateRandomPrice(distance);
+    Itinerary itinerary;
+    for (int i = static_cast<int>(profile.size()) - 1; i >= 0; --i) {
+        timetable.profileItinerary(dst, profile[i], itinerary);
+        double distance = 0.0;
+        std::string legs;
+        for (int k : itinerary.legs) {
+            const Connection& leg = timetable.connections[k];
+            distance += network.straightLineDistance(leg.from, leg.to);
+            if (!legs.empty()) legs += ", ";
+            legs += airports[leg.from].code + " " + formatClock(leg.departure) + " - " + airports[leg.to].code + " " +
+                    formatClock(leg.arrival);
+        }
+        // Map distances are a few hundred units a leg; 500 plus twice
+        // that keeps fares where the per-airport pricing had them.
+        double price = generateRandomPrice(500 + 2 * distance);
         
         FlightTicket ticket;
         ticket.departureAirport = airports[src].code;
         ticket.arrivalAirport = airports[dst].code;
-        ticket.departureDate = flightDate.toString();
-        ticket.departureTime = departureTime;
-        ticket.arrivalTime = arrivalTime;
+        ticket.departureDate = currentDate.toString();
+        ticket.departureTime = formatClock(profile[i].departure);
+        ticket.arrivalTime = formatClock(profile[i].arrival);
+        ticket.itinerary = legs;
         ticket.price = price;
         ticket.isBooked = false;
         
         flightOptions.push_back(ticket);
         
-        std::cout << std::left << std::setw(5) << (i + 1) 
-                  << std::setw(12) << flightDate.toString() 
-                  << std::setw(12) << departureTime 
-                  << std::setw(12) << arrivalTime 
+        std::cout << std::left << std::setw(5) << flightOptions.size() 
+                  << std::setw(12) << ticket.departureDate 
+                  << std::setw(12) << ticket.departureTime 
+                  << std::setw(12) << ticket.arrivalTime 
+                  << std::setw(8) << itinerary.legs.size() - 1 
                   << "$" << std::fixed << std::setprecision(2) << price;
         std::cout << std::endl;
         std::cout.flush();
     }
     printLine();
     
+    int count = static_cast<int>(flightOptions.size());
     int selection;
     do {
-        std::cout << "Select a flight (1-5): ";
+        std::cout << "Select a flight (1-" << count << "): ";
         std::cout.flush();
         std::cin >> selection;
         
-        if (selection < 1 || selection > 5) {
-            std::cout << "Invalid selection. Please enter a number between 1 and 5." << std::endl;
+        if (selection < 1 || selection > count) {
+            std::cout << "Invalid selection. Please enter a number between 1 and " << count << "." << std::endl;
             std::cout.flush();
         }
-    } while (selection < 1 || selection > 5);
+    } while (selection < 1 || selection > count);
     
     FlightTicket selectedTicket = flightOptions[selection - 1];
     
@@ -249,6 +240,7 @@ FlightTicket bookFlight(const std::vector<Airport>& airports, int src, int dst)
     std::cout << "Flight: " << selectedTicket.departureAirport << " to " << selectedTicket.arrivalAirport << std::endl;
     std::cout << "Date: " << selectedTicket.departureDate << std::endl;
     std::cout << "Time: " << selectedTicket.departureTime << " - " << selectedTicket.arrivalTime << std::endl;
+    std::cout << "Itinerary: " << selectedTicket.itinerary << std::endl;
     std::cout << "Seat: " << selectedTicket.seatNumber << std::endl;
     std::cout << "Price: $" << std::fixed << std::setprecision(2) << selectedTicket.price << std::endl;
     printLine('*');
@@ -260,7 +252,30 @@ FlightTicket bookFlight(const std::vector<Airport>& airports, int src, int dst)
     return selectedTicket;
 }
 
-int resolveAirportIndex(const std::string& input, const std::vector<Airport>& airports) {
+// Raw text of one field of a flat JSON reply from the routing service.
+std::string jsonField(const std::string& json, const std::string& key) {
+    std::string pattern = "\"" + key + "\":";
+    size_t at = json.find(pattern);
+    if (at == std::string::npos) return "";
+    at += pattern.size();
+    size_t end = json[at] == '[' ? json.find(']', at) + 1 : json.find_first_of(",}", at);
+    return json.substr(at, end - at);
+}
+
+// Whether the routing service has loaded the same network, going by the
+// airport and edge counts and the fingerprint its PING reply reports.
+bool serviceHasNetwork(LocalSocket& service, const FlightGraph& network) {
+    std::string reply;
+    if (!service.sendLine("PING") || !service.readLine(reply)) return false;
+    char fingerprint[32];
+    std::snprintf(fingerprint, sizeof fingerprint, "\"%016llx\"",
+                  static_cast<unsigned long long>(networkFingerprint(network)));
+    return jsonField(reply, "airports") == std::to_string(network.airportCount()) &&
+           jsonField(reply, "edges") == std::to_string(network.edgeCount()) &&
+           jsonField(reply, "network") == fingerprint;
+}
+
+int resolveAirportIndex(const std::string& input, const std::vector<AirportListing>& airports) {
     bool isNumber = true;
     for (char c : input) {
         if (!std::isdigit(c)) {
@@ -286,9 +301,9 @@ int resolveAirportIndex(const std::string& input, const std::vector<Airport>& ai
     return -1; 
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     std::ios_base::sync_with_stdio(true); 
-    std::vector<Airport> airports = {
+    std::vector<AirportListing> airports = {
         {"JFK", "John F. Kennedy International Airport"},
         {"LAX", "Los Angeles International Airport"},
         {"ORD", "O'Hare International Airport"},
@@ -306,13 +321,46 @@ int main() {
         {"CLT", "Charlotte Douglas International Airport"}
     };
 
+    // booking_system <airports.dat> <routes.dat> books against an OpenFlights
+    // dataset; the simulator is started on the same files so indices agree,
+    // and caches the parsed graph in a snapshot next to the airports file.
+    // Flights are listed from a daily schedule over the network's routes.
+    std::string datasetArgs;
+    FlightGraph network;
+    if (argc == 3) {
+        std::vector<AirportListing> loaded;
+        CsvLoadStats loadStats;
+        bool ok = forEachAirport(argv[1], [&](const AirportRecord& record) {
+            loaded.push_back({std::string(record.code), std::string(record.name)});
+        }, &loadStats);
+        if (!ok) {
+            std::cerr << "Could not read " << argv[1] << std::endl;
+            return 1;
+        }
+        if (!loadNetworkCsv(argv[1], argv[2], network)) {
+            std::cerr << "Could not read " << argv[2] << std::endl;
+            return 1;
+        }
+        airports = std::move(loaded);
+        datasetArgs = std::string(" --airports \"") + argv[1] + "\" --routes \"" + argv[2] + "\" --snapshot \"" + argv[1] + ".graph\"";
+        std::cout << "Loaded " << loadStats.airports << " airports in " << std::fixed << std::setprecision(1)
+                  << loadStats.seconds * 1000 << " ms (" << loadStats.megabytesPerSecond() << " MB/s)" << std::endl;
+    } else {
+        network = makeDefaultNetwork();
+    }
+    Timetable timetable = buildTimetable(network);
+
     printLine('=');
     std::cout << "WELCOME TO FLIGHT BOOKING SYSTEM" << std::endl;
     printLine('=');
     std::cout << "Available Airports (index: code):" << std::endl;
-    for (int i = 0; i < airports.size(); ++i) {
+    const int listLimit = 50;
+    for (int i = 0; i < static_cast<int>(airports.size()) && i < listLimit; ++i) {
         std::cout << "  " << i << ": " << airports[i].code << " - " << airports[i].name << std::endl;
     }
+    if (airports.size() > listLimit) {
+        std::cout << "  ... and " << airports.size() - listLimit << " more (enter a code)" << std::endl;
+    }
     printLine();
 
     std::string input;
@@ -345,12 +393,22 @@ int main() {
         }
     } while (dst < 0 || dst >= airports.size());
 
-    FlightTicket ticket = bookFlight(airports, src, dst);
+    FlightTicket ticket = bookFlight(airports, network, timetable, src, dst);
+    if (!ticket.isBooked) {
+        std::cout << "\nPress Enter to exit...";
+        std::cin.ignore(1);
+        std::cin.get();
+        return 0;
+    }
     
     printLine('=');
     std::cout << "WEATHER CONDITIONS UPDATE" << std::endl;
     printLine('=');
     
+    // Updates in weather feed form, one "<airport> <airport> <0|1>
+    // [description]" line each, for the routing service or the simulator.
+    std::vector<std::string> weatherUpdates;
+
     std::cout << "Would you like to update weather conditions? (y/n): ";
     std::cout.flush();
     std::string updateWeather;
@@ -376,6 +434,11 @@ int main() {
             int a2;
             std::cin >> a2;
 
+            if (a1 < 0 || a1 >= static_cast<int>(airports.size()) || a2 < 0 || a2 >= static_cast<int>(airports.size())) {
+                std::cout << "Invalid airport index, update skipped." << std::endl;
+                continue;
+            }
+
             std::cout << "Enter weather condition (0 for good, 1 for bad): ";
             std::cout.flush();
             int condition;
@@ -390,6 +453,9 @@ int main() {
             } else {
                 description = "Clear skies";
             }
+
+            std::string update = airports[a1].code + " " + airports[a2].code + (condition == 1 ? " 1 " + description : " 0");
+            weatherUpdates.push_back(update);
             
             std::cout << "Weather updated: " 
             << airports[a1].code << " to " 
@@ -399,6 +465,62 @@ int main() {
         }
     }
 
+    // A running routing service (flight_simulator --serve) answers at once
+    // if it has the same network loaded; otherwise the simulator is started
+    // for this booking.
+    LocalSocket service;
+    if (service.connect(kRouteServiceSocket) && !serviceHasNetwork(service, network)) {
+        std::cout << "\nThe routing service has a different network loaded; starting the simulator instead." << std::endl;
+        service.close();
+    }
+    if (service.isOpen()) {
+        std::cout << std::endl;
+        printLine('=');
+        std::cout << "ROUTING SERVICE" << std::endl;
+        printLine('=');
+
+        std::string reply;
+        for (const std::string& update : weatherUpdates) {
+            if (!service.sendLine("WEATHER " + update) || !service.readLine(reply)) break;
+            if (!jsonField(reply, "error").empty()) {
+                std::cout << "Weather update '" << update << "' rejected: " << jsonField(reply, "error") << std::endl;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        bool answered = service.sendLine("ROUTE " + ticket.departureAirport + " " + ticket.arrivalAirport) &&
+                        service.readLine(reply);
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        service.sendLine("QUIT");
+
+        if (answered && jsonField(reply, "error").empty()) {
+            std::string path = jsonField(reply, "path");
+            std::string route;
+            for (char c : path) {
+                if (c == ',') route += " -> ";
+                else if (c != '"' && c != '[' && c != ']') route += c;
+            }
+            if (jsonField(reply, "found") != "true") {
+                std::cout << "No route available between " << ticket.departureAirport << " and "
+                          << ticket.arrivalAirport << " due to weather conditions." << std::endl;
+            } else {
+                if (jsonField(reply, "rerouted") == "true") {
+                    std::cout << "Bad weather on the direct route; your flight has been rerouted." << std::endl;
+                }
+                std::cout << "Route: " << route << " (distance " << jsonField(reply, "distance") << ")" << std::endl;
+            }
+            std::cout << "Route computed by the routing service in " << std::fixed << std::setprecision(0)
+                      << micros << " us" << std::endl;
+            std::cout << "\nThank you for using our booking system!" << std::endl;
+            std::cout << "\nPress Enter to exit...";
+            std::cin.ignore(1);
+            std::cin.get();
+            return 0;
+        }
+        std::cout << "The routing service could not answer (" << (answered ? jsonField(reply, "error") : "no reply")
+                  << "); starting the simulator instead." << std::endl;
+    }
+
     std::cout << std::endl;
     printLine('=');
     std::cout << "LAUNCHING FLIGHT SIMULATOR" << std::endl;
@@ -406,7 +528,14 @@ int main() {
     std::cout << "Starting flight simulation for " << ticket.departureAirport 
             << " to " << ticket.arrivalAirport << "..." << std::endl;
 
-    std::string command = "flight_simulator.exe " + std::to_string(src) + " " + std::to_string(dst);
+    // The simulator receives the updates as a weather feed file.
+    const std::string weatherFeedPath = "weather_updates.txt";
+    std::ofstream weatherFeed(weatherFeedPath, std::ios::trunc);
+    for (const std::string& update : weatherUpdates) weatherFeed << update << "\n";
+    weatherFeed.close();
+    if (weatherFeed) datasetArgs += " --weather-feed \"" + weatherFeedPath + "\"";
+
+    std::string command = "flight_simulator.exe " + std::to_string(src) + " " + std::to_string(dst) + datasetArgs;
     std::cout << "Running: " << command << std::endl;
     
     int result = system(command.c_str());
@@ -1,20 +1,36 @@
 @echo off
 echo Compiling Flight Simulator...
-g++ -o flight_simulator flight_simulator.cpp -lsfml-graphics -lsfml-window -lsfml-system
+g++ -o flight_simulator flight_simulator.cpp -lsfml-graphics -lsfml-window -lsfml-system -lws2_32
 if %ERRORLEVEL% NEQ 0 (
     echo Error compiling flight_simulator.cpp
     pause
     exit /b 1
 )
 
+echo Compiling Headless Router...
+g++ -O2 -pthread -DAERO_HEADLESS -o flight_router flight_simulator.cpp -lws2_32
+if %ERRORLEVEL% NEQ 0 (
+    echo Error compiling headless flight_simulator.cpp
+    pause
+    exit /b 1
+)
+
 echo Compiling Booking System...
-g++ -o booking_system booking_system.cpp
+g++ -o booking_system booking_system.cpp -lws2_32
 if %ERRORLEVEL% NEQ 0 (
     echo Error compiling booking_system.cpp
     pause
     exit /b 1
 )
 
+echo Compiling Route Benchmarks...
+g++ -O2 -pthread -o route_bench route_bench.cpp -lws2_32
+if %ERRORLEVEL% NEQ 0 (
+    echo Error compiling route_bench.cpp
+    pause
+    exit /b 1
+)
+
 echo Compilation successful!
 echo.
 echo Run the booking system with: booking_system.exe
@@ -0,0 +1,322 @@
+#pragma once
+
+#include "flight_graph.hpp"
+
+// Customizable contraction hierarchy over a FlightGraph.
+//
+// build() is the expensive, metric-independent step: it orders the airports
+// by nested dissection on their positions and inserts every shortcut the
+// elimination needs, without witness searches. Because no shortcut is ever
+// skipped, customize() can recompute all shortcut weights for any edge
+// availability (e.g. a weather GraphView) with one pass over the lower
+// triangles, and closed edges simply get infinite weight.
+struct ContractionHierarchy
+{
+    const FlightGraph* graph = nullptr;
+
+    std::vector<int> rank;
+    std::vector<int> parent;
+
+    // Upward arcs of v (towards higher rank) are [upOffset[v], upOffset[v + 1]),
+    // sorted by head airport.
+    std::vector<int> upOffset;
+    std::vector<int> upTail;
+    std::vector<int> upHead;
+    std::vector<int> edgeArc;
+
+    // Metric, filled by customize(). arcMiddle is the airport a shortcut
+    // bypasses, or -1 when the arc is the original edge arcEdge.
+    std::vector<double> arcWeight;
+    std::vector<int> arcMiddle;
+    std::vector<int> arcEdge;
+
+    void build(const FlightGraph& g)
+    {
+        graph = &g;
+        int n = g.airportCount();
+
+        rank.assign(n, -1);
+        std::vector<int> nodes(n);
+        for (int v = 0; v < n; ++v) nodes[v] = v;
+        std::vector<int> mark(n, -1);
+        int nextRank = n - 1;
+        int stamp = 0;
+        dissect(nodes, nextRank, mark, stamp);
+
+        std::vector<int> order(n);
+        for (int v = 0; v < n; ++v) order[rank[v]] = v;
+
+        std::vector<std::vector<int>> up(n);
+        for (int e = 0; e < g.edgeCount(); ++e)
+        {
+            int a = g.edgeFrom[e], b = g.edgeTo[e];
+            if (a == b) continue;
+            if (rank[a] < rank[b]) up[a].push_back(b);
+            else up[b].push_back(a);
+        }
+
+        parent.assign(n, -1);
+        for (int r = 0; r < n; ++r)
+        {
+            int v = order[r];
+            auto& list = up[v];
+            std::sort(list.begin(), list.end());
+            list.erase(std::unique(list.begin(), list.end()), list.end());
+            if (list.empty()) continue;
+
+            int p = list[0];
+            for (int x : list)
+                if (rank[x] < rank[p]) p = x;
+            parent[v] = p;
+            for (int x : list)
+                if (x != p) up[p].push_back(x);
+        }
+
+        upOffset.assign(n + 1, 0);
+        for (int v = 0; v < n; ++v)
+            upOffset[v + 1] = upOffset[v] + static_cast<int>(up[v].size());
+        upTail.resize(upOffset[n]);
+        upHead.resize(upOffset[n]);
+        for (int v = 0; v < n; ++v)
+        {
+            std::copy(up[v].begin(), up[v].end(), upHead.begin() + upOffset[v]);
+            std::fill(upTail.begin() + upOffset[v], upTail.begin() + upOffset[v + 1], v);
+        }
+
+        edgeArc.assign(g.edgeCount(), -1);
+        for (int e = 0; e < g.edgeCount(); ++e)
+        {
+            int a = g.edgeFrom[e], b = g.edgeTo[e];
+            if (a != b) edgeArc[e] = findArc(a, b);
+        }
+
+        customize(GraphView(g));
+    }
+
+    int arcCount() const { return static_cast<int>(upHead.size()); }
+
+    // Arc between u and v in either direction, or -1.
+    int findArc(int u, int v) const
+    {
+        if (rank[u] > rank[v]) std::swap(u, v);
+        auto first = upHead.begin() + upOffset[u];
+        auto last = upHead.begin() + upOffset[u + 1];
+        auto it = std::lower_bound(first, last, v);
+        if (it == last || *it != v) return -1;
+        return static_cast<int>(it - upHead.begin());
+    }
+
+    // Recomputes every arc weight for the availability seen through view.
+    // Cost is one sweep over the lower triangles; the topology is untouched.
+    void customize(const GraphView& view)
+    {
+        const FlightGraph& g = *graph;
+        const double inf = std::numeric_limits<double>::infinity();
+        int m = arcCount();
+
+        arcWeight.assign(m, inf);
+        arcMiddle.assign(m, -1);
+        arcEdge.assign(m, -1);
+        for (int e = 0; e < g.edgeCount(); ++e)
+        {
+            int a = edgeArc[e];
+            if (a < 0 || !view.isAvailable(e)) continue;
+            if (g.edgeWeight[e] < arcWeight[a])
+            {
+                arcWeight[a] = g.edgeWeight[e];
+                arcEdge[a] = e;
+            }
+        }
+
+        int n = g.airportCount();
+        std::vector<int> order(n);
+        for (int v = 0; v < n; ++v) order[rank[v]] = v;
+
+        for (int v : order)
+        {
+            for (int i = upOffset[v]; i < upOffset[v + 1]; ++i)
+            {
+                if (arcWeight[i] == inf) continue;
+                for (int j = i + 1; j < upOffset[v + 1]; ++j)
+                {
+                    double through = arcWeight[i] + arcWeight[j];
+                    int a = findArc(upHead[i], upHead[j]);
+                    if (through < arcWeight[a])
+                    {
+                        arcWeight[a] = through;
+                        arcMiddle[a] = v;
+                    }
+                }
+            }
+        }
+    }
+
+    // Elimination-tree query: every upward neighbour of a node is one of its
+    // ancestors, so the search simply scans the root paths of src and dst.
+    std::vector<int> query(int src, int dst, SearchStats* stats = nullptr) const
+    {
+        std::vector<int> path;
+        query(src, dst, path, stats);
+        return path;
+    }
+
+    void query(int src, int dst, std::vector<int>& path, SearchStats* stats = nullptr,
+               SearchWorkspace& ws = SearchWorkspace::local()) const
+    {
+        const double inf = std::numeric_limits<double>::infinity();
+        ws.labels[0].reset(graph->airportCount());
+        ws.labels[1].reset(graph->airportCount());
+        path.clear();
+        int scanned = 0;
+
+        // labels[side].prev holds the arc that reached a node, not a node.
+        int ends[2] = {src, dst};
+        for (int side = 0; side < 2; ++side)
+        {
+            SearchLabels& labels = ws.labels[side];
+            labels.set(ends[side], 0, -1);
+            for (int x = ends[side]; x != -1; x = parent[x])
+            {
+                ++scanned;
+                double d = labels.distance(x);
+                if (d == inf) continue;
+                for (int a = upOffset[x]; a < upOffset[x + 1]; ++a)
+                {
+                    double alt = d + arcWeight[a];
+                    if (alt < labels.distance(upHead[a]))
+                        labels.set(upHead[a], alt, a);
+                }
+            }
+        }
+
+        double best = inf;
+        int meet = -1;
+        for (int x = src; x != -1; x = parent[x])
+        {
+            double through = ws.labels[0].distance(x) + ws.labels[1].distance(x);
+            if (through < best)
+            {
+                best = through;
+                meet = x;
+            }
+        }
+
+        if (stats)
+        {
+            stats->settled = scanned;
+            stats->distance = best;
+        }
+        if (meet < 0) return;
+
+        // Forward arcs are collected meet -> src, then unpacked in reverse.
+        std::vector<int>& arcs = ws.scratch;
+        arcs.clear();
+        for (int x = meet; ws.labels[0].parent(x) != -1; x = upTail[ws.labels[0].parent(x)])
+            arcs.push_back(ws.labels[0].parent(x));
+
+        path.push_back(src);
+        int at = src;
+        for (auto it = arcs.rbegin(); it != arcs.rend(); ++it)
+        {
+            unpack(at, upHead[*it], path, ws);
+            at = upHead[*it];
+        }
+        for (int x = meet; ws.labels[1].parent(x) != -1; x = upTail[ws.labels[1].parent(x)])
+        {
+            unpack(x, upTail[ws.labels[1].parent(x)], path, ws);
+        }
+    }
+
+private:
+    // Appends the original airports strictly after `from` up to and
+    // including `to` for the arc joining them.
+    void unpack(int from, int to, std::vector<int>& path, SearchWorkspace& ws) const
+    {
+        auto& stack = ws.pairStack;
+        stack.clear();
+        stack.push_back({from, to});
+        while (!stack.empty())
+        {
+            auto [u, v] = stack.back();
+            stack.pop_back();
+            int a = findArc(u, v);
+            int mid = arcMiddle[a];
+            if (mid < 0)
+            {
+                path.push_back(v);
+                continue;
+            }
+            stack.push_back({mid, v});
+            stack.push_back({u, mid});
+        }
+    }
+
+    // Nested dissection by coordinate bisection: split at the median of the
+    // wider axis, take the boundary of the smaller-boundary half as the
+    // separator and give it the highest remaining ranks.
+    void dissect(std::vector<int>& nodes, int& nextRank, std::vector<int>& mark, int& stamp)
+    {
+        const FlightGraph& g = *graph;
+        if (nodes.size() <= 2)
+        {
+            for (int v : nodes) rank[v] = nextRank--;
+            return;
+        }
+
+        float minX = g.airports[nodes[0]].position.x, maxX = minX;
+        float minY = g.airports[nodes[0]].position.y, maxY = minY;
+        for (int v : nodes)
+        {
+            const auto& p = g.airports[v].position;
+            minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+        }
+        bool byX = maxX - minX >= maxY - minY;
+        size_t half = nodes.size() / 2;
+        std::nth_element(nodes.begin(), nodes.begin() + half, nodes.end(), [&](int a, int b) {
+            const auto& pa = g.airports[a].position;
+            const auto& pb = g.airports[b].position;
+            return byX ? pa.x < pb.x : pa.y < pb.y;
+        });
+
+        // mark[v] == stampA / stampB tells which half v fell into.
+        int stampA = ++stamp, stampB = ++stamp;
+        for (size_t i = 0; i < nodes.size(); ++i)
+            mark[nodes[i]] = i < half ? stampA : stampB;
+
+        std::vector<int> boundary[2];
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            int v = nodes[i];
+            int other = mark[v] == stampA ? stampB : stampA;
+            for (int a = g.arcOffset[v]; a < g.arcOffset[v + 1]; ++a)
+            {
+                if (mark[g.arcTarget[a]] == other)
+                {
+                    boundary[i < half ? 0 : 1].push_back(v);
+                    break;
+                }
+            }
+        }
+
+        const std::vector<int>& separator = boundary[0].size() <= boundary[1].size() ? boundary[0] : boundary[1];
+        int sepStamp = ++stamp;
+        for (int v : separator)
+        {
+            mark[v] = sepStamp;
+            rank[v] = nextRank--;
+        }
+
+        std::vector<int> lower, upper;
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            int v = nodes[i];
+            if (mark[v] == sepStamp) continue;
+            (i < half ? lower : upper).push_back(v);
+        }
+        nodes.clear();
+        nodes.shrink_to_fit();
+        dissect(upper, nextRank, mark, stamp);
+        dissect(lower, nextRank, mark, stamp);
+    }
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <cstddef>
+
+#include "mapped_file.hpp"
+
+// Splits one CSV row per call into string_views over the input buffer.
+// Quoted fields are returned without their quotes and are not unescaped;
+// fields past maxFields are skipped.
+struct CsvReader
+{
+    const char* at;
+    const char* end;
+
+    CsvReader(const char* begin, size_t size) : at(begin), end(begin + size) {}
+
+    bool nextRow(std::string_view* fields, int maxFields, int& count)
+    {
+        count = 0;
+        if (at >= end) return false;
+        for (;;)
+        {
+            const char* start;
+            const char* stop;
+            if (at < end && *at == '"')
+            {
+                start = ++at;
+                while (at < end && !(*at == '"' && (at + 1 == end || at[1] == ',' || at[1] == '\n' || at[1] == '\r')))
+                    ++at;
+                stop = at;
+                if (at < end) ++at;
+            }
+            else
+            {
+                start = at;
+                while (at < end && *at != ',' && *at != '\n' && *at != '\r') ++at;
+                stop = at;
+            }
+            if (count < maxFields) fields[count] = std::string_view(start, stop - start);
+            ++count;
+
+            if (at < end && *at == ',')
+            {
+                ++at;
+                continue;
+            }
+            while (at < end && *at != '\n') ++at;
+            if (at < end) ++at;
+            if (count > maxFields) count = maxFields;
+            return true;
+        }
+    }
+};
+
+// "\N" marks a missing value in the OpenFlights data.
+inline bool isMissingField(std::string_view field)
+{
+    return field.empty() || field == "\\N";
+}
+
+inline bool parseCsvInt(std::string_view field, int& value)
+{
+    if (isMissingField(field)) return false;
+    size_t i = 0;
+    bool negative = field[0] == '-';
+    if (negative || field[0] == '+') ++i;
+    if (i == field.size()) return false;
+    long long result = 0;
+    for (; i < field.size(); ++i)
+    {
+        if (field[i] < '0' || field[i] > '9') return false;
+        result = result * 10 + (field[i] - '0');
+        if (result > 2147483647LL) return false;
+    }
+    value = static_cast<int>(negative ? -result : result);
+    return true;
+}
+
+// Plain decimal notation only ([-]digits[.digits]), which is all the
+// coordinate columns use.
+inline bool parseCsvDouble(std::string_view field, double& value)
+{
+    if (isMissingField(field)) return false;
+    size_t i = 0;
+    bool negative = field[0] == '-';
+    if (negative || field[0] == '+') ++i;
+    double result = 0.0;
+    bool digits = false;
+    for (; i < field.size() && field[i] >= '0' && field[i] <= '9'; ++i, digits = true)
+        result = result * 10.0 + (field[i] - '0');
+    if (i < field.size() && field[i] == '.')
+    {
+        double scale = 0.1;
+        for (++i; i < field.size() && field[i] >= '0' && field[i] <= '9'; ++i, digits = true, scale *= 0.1)
+            result += (field[i] - '0') * scale;
+    }
+    if (!digits || i != field.size()) return false;
+    value = negative ? -result : result;
+    return true;
+}
+
+// One usable row of an OpenFlights airports.dat file. The views point into
+// the mapped file and are only valid inside the callback.
+struct AirportRecord
+{
+    int id;
+    std::string_view name;
+    std::string_view code;
+    double latitude;
+    double longitude;
+};
+
+// One row of an OpenFlights routes.dat file. Airport ids are -1 when the
+// file has "\N" for them; the codes are always present.
+struct RouteRecord
+{
+    std::string_view sourceCode;
+    int sourceId;
+    std::string_view destinationCode;
+    int destinationId;
+};
+
+struct CsvLoadStats
+{
+    size_t bytes = 0;
+    double seconds = 0.0;
+    int airports = 0;
+    int routes = 0;
+    int skipped = 0;
+
+    double megabytesPerSecond() const
+    {
+        return seconds > 0.0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0;
+    }
+};
+
+// Calls fn(const AirportRecord&) for every airport with a code and valid
+// coordinates, in file order. Rows without them are counted as skipped, so
+// every consumer of the same file sees the same airport indices.
+// Layout: id,name,city,country,IATA,ICAO,latitude,longitude,...
+template <typename Fn>
+bool forEachAirport(const std::string& path, Fn fn, CsvLoadStats* stats = nullptr)
+{
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    CsvReader reader(file.data, file.size);
+    std::string_view fields[8];
+    int count;
+    int airports = 0, skipped = 0;
+    while (reader.nextRow(fields, 8, count))
+    {
+        AirportRecord record;
+        if (count < 8 || !parseCsvInt(fields[0], record.id) ||
+            !parseCsvDouble(fields[6], record.latitude) || !parseCsvDouble(fields[7], record.longitude))
+        {
+            ++skipped;
+            continue;
+        }
+        record.name = fields[1];
+        record.code = !isMissingField(fields[4]) ? fields[4] : fields[5];
+        if (isMissingField(record.code))
+        {
+            ++skipped;
+            continue;
+        }
+        fn(record);
+        ++airports;
+    }
+
+    if (stats)
+    {
+        stats->bytes += file.size;
+        stats->airports += airports;
+        stats->skipped += skipped;
+        stats->seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return true;
+}
+
+// Calls fn(const RouteRecord&) for every route row, in file order.
+// Layout: airline,airlineId,source,sourceId,destination,destinationId,...
+template <typename Fn>
+bool forEachRoute(const std::string& path, Fn fn, CsvLoadStats* stats = nullptr)
+{
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    CsvReader reader(file.data, file.size);
+    std::string_view fields[6];
+    int count;
+    int routes = 0, skipped = 0;
+    while (reader.nextRow(fields, 6, count))
+    {
+        if (count < 6 || isMissingField(fields[2]) || isMissingField(fields[4]))
+        {
+            ++skipped;
+            continue;
+        }
+        RouteRecord record;
+        record.sourceCode = fields[2];
+        record.destinationCode = fields[4];
+        if (!parseCsvInt(fields[3], record.sourceId)) record.sourceId = -1;
+        if (!parseCsvInt(fields[5], record.destinationId)) record.destinationId = -1;
+        fn(record);
+        ++routes;
+    }
+
+    if (stats)
+    {
+        stats->bytes += file.size;
+        stats->routes += routes;
+        stats->skipped += skipped;
+        stats->seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return true;
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include "flight_graph.hpp"
+#include <unordered_map>
+
+// Shortest-path tree from one source that follows the live availability of
+// a FlightGraph. After an edge changes, only the region whose distances can
+// change is repaired (Ramalingam-Reps style):
+//  - closing a tree edge invalidates the subtree below it, which is then
+//    re-seeded from its unaffected neighbours and settled by a Dijkstra
+//    restricted to that subtree;
+//  - opening an edge can only shorten distances, so a decrease-only
+//    Dijkstra runs from whichever endpoint improved.
+// Closing a non-tree edge or opening an edge that does not improve either
+// endpoint costs O(1).
+struct ShortestPathTree
+{
+    const FlightGraph* graph = nullptr;
+    int source = -1;
+    std::vector<double> dist;
+    std::vector<int> parent;
+    std::vector<int> parentEdge;
+
+    std::vector<int> mark;
+    int stamp = 0;
+    std::vector<int> affected;
+
+    using PDI = std::pair<double, int>;
+    std::priority_queue<PDI, std::vector<PDI>, std::greater<>> pq;
+
+    void build(const FlightGraph& g, int src)
+    {
+        graph = &g;
+        source = src;
+        int n = g.airportCount();
+        dist.assign(n, std::numeric_limits<double>::infinity());
+        parent.assign(n, -1);
+        parentEdge.assign(n, -1);
+        mark.assign(n, 0);
+        stamp = 0;
+
+        dist[src] = 0;
+        pq.push({0, src});
+        settle(false);
+    }
+
+    // Returns the number of airports whose label was recomputed.
+    int edgeChanged(int e)
+    {
+        const FlightGraph& g = *graph;
+        if (g.isAvailable(e))
+            return edgeOpened(e);
+        return edgeClosed(e);
+    }
+
+    std::vector<int> pathTo(int dst) const
+    {
+        if (dist[dst] == std::numeric_limits<double>::infinity()) return {};
+        std::vector<int> path;
+        for (int at = dst; at != -1; at = parent[at])
+            path.push_back(at);
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+private:
+    int edgeOpened(int e)
+    {
+        const FlightGraph& g = *graph;
+        int a = g.edgeFrom[e], b = g.edgeTo[e];
+        double w = g.edgeWeight[e];
+        if (dist[a] + w < dist[b])
+        {
+            dist[b] = dist[a] + w;
+            parent[b] = a;
+            parentEdge[b] = e;
+            pq.push({dist[b], b});
+        }
+        else if (dist[b] + w < dist[a])
+        {
+            dist[a] = dist[b] + w;
+            parent[a] = b;
+            parentEdge[a] = e;
+            pq.push({dist[a], a});
+        }
+        return settle(false);
+    }
+
+    int edgeClosed(int e)
+    {
+        const FlightGraph& g = *graph;
+        int child = -1;
+        if (parentEdge[g.edgeTo[e]] == e) child = g.edgeTo[e];
+        else if (parentEdge[g.edgeFrom[e]] == e) child = g.edgeFrom[e];
+        if (child < 0) return 0;
+
+        ++stamp;
+        affected.clear();
+        affected.push_back(child);
+        mark[child] = stamp;
+        for (size_t i = 0; i < affected.size(); ++i)
+        {
+            int x = affected[i];
+            for (int a = g.arcOffset[x]; a < g.arcOffset[x + 1]; ++a)
+            {
+                int y = g.arcTarget[a];
+                if (parent[y] == x && parentEdge[y] == g.arcEdge[a] && mark[y] != stamp)
+                {
+                    mark[y] = stamp;
+                    affected.push_back(y);
+                }
+            }
+        }
+
+        for (int x : affected)
+        {
+            dist[x] = std::numeric_limits<double>::infinity();
+            parent[x] = -1;
+            parentEdge[x] = -1;
+        }
+        for (int x : affected)
+        {
+            for (int a = g.arcOffset[x]; a < g.arcOffset[x + 1]; ++a)
+            {
+                int y = g.arcTarget[a];
+                if (mark[y] == stamp || !g.isAvailable(g.arcEdge[a])) continue;
+                double alt = dist[y] + g.arcWeight[a];
+                if (alt < dist[x])
+                {
+                    dist[x] = alt;
+                    parent[x] = y;
+                    parentEdge[x] = g.arcEdge[a];
+                }
+            }
+            if (dist[x] < std::numeric_limits<double>::infinity())
+                pq.push({dist[x], x});
+        }
+        settle(true);
+        return static_cast<int>(affected.size());
+    }
+
+    // Drains pq. When restricted, relaxations stay inside the current
+    // affected set: distances outside it did not change.
+    int settle(bool restricted)
+    {
+        const FlightGraph& g = *graph;
+        int settled = 0;
+        while (!pq.empty())
+        {
+            auto [d, u] = pq.top(); pq.pop();
+            if (d > dist[u]) continue;
+            ++settled;
+
+            for (int a = g.arcOffset[u]; a < g.arcOffset[u + 1]; ++a)
+            {
+                int v = g.arcTarget[a];
+                if (restricted && mark[v] != stamp) continue;
+                if (!g.isAvailable(g.arcEdge[a])) continue;
+
+                double alt = d + g.arcWeight[a];
+                if (alt < dist[v])
+                {
+                    dist[v] = alt;
+                    parent[v] = u;
+                    parentEdge[v] = g.arcEdge[a];
+                    pq.push({alt, v});
+                }
+            }
+        }
+        return settled;
+    }
+};
+
+// Keeps one ShortestPathTree per tracked source up to date with weather
+// changes applied through FlightGraph::updateWeather.
+struct RouteTracker
+{
+    const FlightGraph* graph;
+    std::vector<ShortestPathTree> trees;
+    std::unordered_map<int, int> treeOf;
+    long long lastRepairWork = 0;
+
+    explicit RouteTracker(const FlightGraph& g) : graph(&g) {}
+
+    void trackSource(int src)
+    {
+        if (treeOf.count(src)) return;
+        treeOf[src] = static_cast<int>(trees.size());
+        trees.emplace_back();
+        trees.back().build(*graph, src);
+    }
+
+    // Call after the availability of edge e changed in the graph.
+    void edgeChanged(int e)
+    {
+        lastRepairWork = 0;
+        if (e < 0) return;
+        for (auto& tree : trees)
+            lastRepairWork += tree.edgeChanged(e);
+    }
+
+    bool isTracked(int src) const { return treeOf.count(src) != 0; }
+
+    double distance(int src, int dst) const
+    {
+        return trees[treeOf.at(src)].dist[dst];
+    }
+
+    std::vector<int> path(int src, int dst) const
+    {
+        return trees[treeOf.at(src)].pathTo(dst);
+    }
+};
@@ -0,0 +1,384 @@
+#pragma once
+
+#include "flight_graph.hpp"
+#include <functional>
+#include <random>
+#include <chrono>
+#include <memory>
+#include <cmath>
+
+// Calendar queue (Brown, 1988): a priority queue for event times that
+// mostly move forward. Time is cut into buckets of equal width laid out
+// on a ring ("days of a year"); an event goes to the bucket of its time,
+// and pop() walks the ring from the current day, taking the earliest event
+// of a bucket only if it falls on that day. Buckets are kept sorted and
+// stay short because the bucket count follows the queue size and the
+// width follows the spacing of the earliest events, so push and pop cost
+// O(1) on average instead of a heap's O(log n). Events with equal times
+// come out in the order they were pushed.
+template <typename T>
+struct CalendarQueue
+{
+    CalendarQueue() { rebuild(kMinBuckets, 1.0); }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    void push(double time, const T& value)
+    {
+        std::int64_t d = dayOf(time);
+        if (count == 0 || d < day) day = d;
+        insert(Entry{time, nextSequence++, value});
+        if (++count > 2 * buckets.size()) resize(2 * buckets.size());
+    }
+
+    // Removes the earliest entry; the queue must not be empty.
+    T pop(double& time)
+    {
+        size_t mask = buckets.size() - 1;
+        Entry* found = nullptr;
+        for (size_t k = 0; k < buckets.size(); ++k, ++day)
+        {
+            std::vector<Entry>& bucket = buckets[day & mask];
+            if (!bucket.empty() && dayOf(bucket.back().time) <= day)
+            {
+                found = &bucket.back();
+                break;
+            }
+        }
+        if (!found)
+        {
+            // Nothing within a year: jump straight to the earliest event.
+            for (std::vector<Entry>& bucket : buckets)
+                if (!bucket.empty() && (!found || earlier(bucket.back(), *found))) found = &bucket.back();
+            day = dayOf(found->time);
+        }
+
+        time = found->time;
+        T value = found->value;
+        buckets[day & mask].pop_back();
+        if (--count < buckets.size() / 2 && buckets.size() > kMinBuckets) resize(buckets.size() / 2);
+        return value;
+    }
+
+private:
+    static constexpr size_t kMinBuckets = 16;
+    static constexpr size_t kWidthSample = 32;
+
+    struct Entry
+    {
+        double time;
+        std::uint64_t sequence;
+        T value;
+    };
+
+    std::vector<std::vector<Entry>> buckets;    // each sorted latest first
+    double width = 1.0;
+    std::int64_t day = 0;                       // current bucket, not wrapped
+    size_t count = 0;
+    std::uint64_t nextSequence = 0;
+
+    static bool earlier(const Entry& a, const Entry& b)
+    {
+        return a.time < b.time || (a.time == b.time && a.sequence < b.sequence);
+    }
+
+    std::int64_t dayOf(double time) const { return static_cast<std::int64_t>(std::floor(time / width)); }
+
+    void insert(const Entry& e)
+    {
+        std::vector<Entry>& bucket = buckets[dayOf(e.time) & (buckets.size() - 1)];
+        auto at = std::upper_bound(bucket.begin(), bucket.end(), e, [](const Entry& a, const Entry& b) { return earlier(b, a); });
+        bucket.insert(at, e);
+    }
+
+    // New bucket count, with the width set to three times the mean gap
+    // between the earliest events (ignoring gaps far above the mean).
+    void resize(size_t bucketCount)
+    {
+        std::vector<Entry> all;
+        all.reserve(count);
+        for (std::vector<Entry>& bucket : buckets) all.insert(all.end(), bucket.begin(), bucket.end());
+
+        double newWidth = width;
+        size_t sample = std::min(all.size(), kWidthSample);
+        if (sample >= 2)
+        {
+            std::partial_sort(all.begin(), all.begin() + sample, all.end(), earlier);
+            double span = all[sample - 1].time - all[0].time;
+            double mean = span / (sample - 1), total = 0.0;
+            int gaps = 0;
+            for (size_t i = 1; i < sample; ++i)
+            {
+                double gap = all[i].time - all[i - 1].time;
+                if (gap <= 2.0 * mean)
+                {
+                    total += gap;
+                    ++gaps;
+                }
+            }
+            if (gaps > 0 && total > 0.0) newWidth = 3.0 * total / gaps;
+        }
+        rebuild(bucketCount, newWidth);
+        for (const Entry& e : all) insert(e);
+        if (!all.empty()) day = dayOf(std::min_element(all.begin(), all.end(), earlier)->time);
+    }
+
+    void rebuild(size_t bucketCount, double newWidth)
+    {
+        buckets.assign(bucketCount, {});
+        width = newWidth;
+        day = 0;
+    }
+};
+
+struct FleetEventOptions
+{
+    int aircraft = 1000;
+    double hours = 24.0;             // simulated time to run
+    double speed = 250.0;            // map units per hour
+    double turnaround = 1.0;         // hours on the ground between flights
+    double weatherInterval = 0.5;    // hours between weather epochs
+    SearchMode mode = SearchMode::AStar;
+    unsigned seed = 1;
+};
+
+struct FleetEventStats
+{
+    long long events = 0;
+    long long departures = 0;
+    long long legs = 0;              // waypoints reached
+    long long landings = 0;
+    long long weatherEpochs = 0;
+    long long edgesClosed = 0;       // edges that turned unavailable
+    long long reroutes = 0;          // airborne aircraft sent on a new route
+    long long grounded = 0;          // times an aircraft found no route and waited
+    long long searches = 0;
+    double searchSeconds = 0.0;      // of seconds, spent routing
+    double simulatedHours = 0.0;
+    double seconds = 0.0;
+
+    double eventsPerSecond() const { return seconds > 0.0 ? events / seconds : 0.0; }
+};
+
+// Returns false once it has no more weather; fills changed with the edges
+// whose availability flipped.
+using WeatherSource = std::function<bool(FlightGraph&, std::vector<int>& changed)>;
+
+// Weather that turns count random edges bad (with probability badFraction,
+// under a random hazard) or clear at every epoch.
+inline WeatherSource randomWeather(int count, double badFraction, unsigned seed)
+{
+    auto rng = std::make_shared<std::mt19937>(seed);
+    auto updates = std::make_shared<std::vector<WeatherUpdate>>();
+    return [=](FlightGraph& graph, std::vector<int>& changed) {
+        std::uniform_int_distribution<int> edge(0, graph.edgeCount() - 1);
+        std::uniform_int_distribution<int> hazard(0, kHazardCount - 1);
+        std::bernoulli_distribution bad(badFraction);
+        updates->clear();
+        for (int k = 0; k < count && graph.edgeCount() > 0; ++k)
+        {
+            bool isBad = bad(*rng);
+            std::uint32_t description = isBad ? graph.internDescription(hazardName(static_cast<Hazard>(hazard(*rng)))) : 0;
+            updates->push_back({edge(*rng), isBad, description});
+        }
+        graph.applyWeatherUpdates(*updates, &changed);
+        return true;
+    };
+}
+
+// Discrete-event simulation of a fleet flying between random airports.
+// Nothing happens between events:
+//
+//   Departure      the aircraft picks a destination and is routed there
+//                  on the current weather
+//   Arrival        it reaches the next waypoint of its route and flies the
+//                  next leg, or lands and departs again after turnaround
+//   WeatherEpoch   the weather source advances one epoch; every airborne
+//                  aircraft whose remaining legs lost an edge is rerouted
+//                  from the waypoint it is flying to, and grounded
+//                  aircraft try again
+//
+// An aircraft that finds no route waits on the ground for the next epoch.
+// The graph's weather is changed in place.
+struct FleetEventSimulation
+{
+    FleetEventSimulation(FlightGraph& g, const FleetEventOptions& o, WeatherSource source = nullptr)
+        : graph(g), options(o), weather(std::move(source)), rng(o.seed)
+    {
+    }
+
+    void run(FleetEventStats& stats)
+    {
+        stats = FleetEventStats();
+        auto start = std::chrono::steady_clock::now();
+        int n = options.aircraft;
+        location.assign(n, 0);
+        destination.assign(n, -1);
+        next.assign(n, 0);
+        airborne.assign(n, 0);
+        routes.assign(n, {});
+        routeEdges.assign(n, {});
+        waiting.clear();
+        if (graph.airportCount() < 2) return;
+
+        std::uniform_int_distribution<int> airport(0, graph.airportCount() - 1);
+        std::uniform_real_distribution<double> offset(0.0, options.turnaround);
+        for (int a = 0; a < n; ++a)
+        {
+            location[a] = airport(rng);
+            queue.push(offset(rng), Event{Departure, a});
+        }
+        if (weather) queue.push(options.weatherInterval, Event{WeatherEpoch, -1});
+
+        double now = 0.0;
+        while (!queue.empty())
+        {
+            Event event = queue.pop(now);
+            if (now > options.hours) break;
+            ++stats.events;
+            switch (event.kind)
+            {
+            case Departure: depart(event.aircraft, now, stats); break;
+            case Arrival: arrive(event.aircraft, now, stats); break;
+            case WeatherEpoch: weatherEpoch(now, stats); break;
+            }
+        }
+        stats.simulatedHours = std::min(now, options.hours);
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    enum Kind : std::uint8_t
+    {
+        Departure,
+        Arrival,
+        WeatherEpoch
+    };
+
+    struct Event
+    {
+        Kind kind;
+        int aircraft;
+    };
+
+    FlightGraph& graph;
+    FleetEventOptions options;
+    WeatherSource weather;
+    std::mt19937 rng;
+    CalendarQueue<Event> queue;
+
+    // Per aircraft: the airport it is at or last passed, where it is
+    // going, its route and the index of the waypoint it is flying to.
+    std::vector<int> location;
+    std::vector<int> destination;
+    std::vector<int> next;
+    std::vector<std::uint8_t> airborne;
+    std::vector<std::vector<int>> routes;
+    std::vector<std::vector<int>> routeEdges;
+    std::vector<int> waiting;
+    std::vector<int> changed;
+    std::vector<int> path;
+
+    // Routes aircraft a from airport from (where it is, or the waypoint it
+    // is flying to) to its destination. The old route is kept if there is
+    // no new one.
+    bool route(int a, int from, FleetEventStats& stats)
+    {
+        ++stats.searches;
+        auto start = std::chrono::steady_clock::now();
+        GraphView(graph).shortestPath(from, destination[a], path, options.mode);
+        stats.searchSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (path.empty()) return false;
+        routes[a].swap(path);
+        graph.pathEdges(routes[a], routeEdges[a]);
+        next[a] = 0;
+        return true;
+    }
+
+    void flyLeg(int a, double now)
+    {
+        int e = routeEdges[a][next[a]];
+        ++next[a];
+        airborne[a] = 1;
+        queue.push(now + graph.edgeWeight[e] / options.speed, Event{Arrival, a});
+    }
+
+    void depart(int a, double now, FleetEventStats& stats)
+    {
+        if (destination[a] < 0)
+        {
+            std::uniform_int_distribution<int> airport(0, graph.airportCount() - 2);
+            int d = airport(rng);
+            destination[a] = d >= location[a] ? d + 1 : d;
+        }
+        if (!route(a, location[a], stats))
+        {
+            ++stats.grounded;
+            waiting.push_back(a);
+            return;
+        }
+        ++stats.departures;
+        flyLeg(a, now);
+    }
+
+    void arrive(int a, double now, FleetEventStats& stats)
+    {
+        ++stats.legs;
+        airborne[a] = 0;
+        location[a] = routes[a][next[a]];
+        if (location[a] == destination[a])
+        {
+            ++stats.landings;
+            destination[a] = -1;
+            queue.push(now + options.turnaround, Event{Departure, a});
+            return;
+        }
+        // Rerouting at the last epoch may have failed; the aircraft then
+        // waits here for the weather to change.
+        if (!graph.isAvailable(routeEdges[a][next[a]]) && !route(a, location[a], stats))
+        {
+            ++stats.grounded;
+            waiting.push_back(a);
+            return;
+        }
+        flyLeg(a, now);
+    }
+
+    void weatherEpoch(double now, FleetEventStats& stats)
+    {
+        changed.clear();
+        if (!weather(graph, changed)) return;
+        ++stats.weatherEpochs;
+        bool anyClosed = false;
+        for (int e : changed)
+        {
+            bool closed = !graph.isAvailable(e);
+            stats.edgesClosed += closed;
+            anyClosed |= closed;
+        }
+
+        if (anyClosed)
+        {
+            for (int a = 0; a < options.aircraft; ++a)
+            {
+                // Airborne aircraft only; the leg being flown is finished
+                // either way.
+                const std::vector<int>& edges = routeEdges[a];
+                if (!airborne[a] || static_cast<size_t>(next[a]) >= edges.size()) continue;
+                if (!anyEdgeUnavailable(graph.availableBits.data(), edges.data() + next[a], edges.size() - next[a]))
+                    continue;
+                // The new route starts at the waypoint being flown to, so
+                // the pending arrival there stays valid. Without one the
+                // aircraft keeps its route and arrive() holds it at the
+                // first closed leg.
+                if (route(a, routes[a][next[a]], stats)) ++stats.reroutes;
+            }
+        }
+
+        std::vector<int> retry;
+        retry.swap(waiting);
+        for (int a : retry) queue.push(now, Event{Departure, a});
+        queue.push(now + options.weatherInterval, Event{WeatherEpoch, -1});
+    }
+};
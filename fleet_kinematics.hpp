@@ -0,0 +1,209 @@
+#pragma once
+
+#include "flight_graph.hpp"
+#include <cmath>
+#include <random>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Positions of many aircraft flying routes across the map. Route geometry
+// is stored once per route: its points, the arc length flown at each
+// point, and each segment's unit direction. Aircraft state is a set of
+// flat arrays (structure of arrays), one entry per aircraft.
+//
+// Every aircraft keeps a cursor on its current segment and a copy of that
+// segment's origin, direction and end, refreshed only when it moves on to
+// the next segment. A step is then distance += speed * dt and
+// position = origin + direction * (distance - originArc) over whole
+// arrays, done with SSE2/AVX2 where available; the cursors only move for
+// the few aircraft that crossed a waypoint. Aircraft loop over their
+// route, as the single animated flight always has.
+struct FleetKinematics
+{
+    // Route geometry. Route r owns points [routeFirst[r], routeFirst[r + 1]).
+    std::vector<float> pointX;
+    std::vector<float> pointY;
+    std::vector<float> pointArc;
+    std::vector<float> segmentDirX;    // stored at the segment's first point
+    std::vector<float> segmentDirY;
+    std::vector<int> routeFirst{0};
+
+    // Aircraft state.
+    std::vector<int> route;
+    std::vector<int> cursor;           // first point of the current segment
+    std::vector<float> distance;       // flown along the route
+    std::vector<float> speed;          // map units per second
+    std::vector<float> originX;
+    std::vector<float> originY;
+    std::vector<float> originArc;
+    std::vector<float> segmentEnd;     // arc length at the segment's far end
+    std::vector<float> dirX;
+    std::vector<float> dirY;
+    std::vector<float> x;              // position after the last advance()
+    std::vector<float> y;
+
+    int size() const { return static_cast<int>(route.size()); }
+    int routeCount() const { return static_cast<int>(routeFirst.size()) - 1; }
+    float routeLength(int r) const { return pointArc[routeFirst[r + 1] - 1]; }
+
+    // Segment the aircraft is on, counted from the start of its route.
+    int segment(int a) const { return cursor[a] - routeFirst[route[a]]; }
+
+    // Adds the route through the airports of path. Returns -1 if the path
+    // has fewer than two airports or no length.
+    int addRoute(const FlightGraph& graph, const std::vector<int>& path)
+    {
+        if (path.size() < 2) return -1;
+        float arc = 0.0f;
+        for (size_t k = 0; k < path.size(); ++k)
+        {
+            const MapPoint& p = graph.airports[path[k]].position;
+            if (k > 0)
+            {
+                float dx = p.x - pointX.back(), dy = p.y - pointY.back();
+                float length = std::sqrt(dx * dx + dy * dy);
+                segmentDirX.back() = length > 0.0f ? dx / length : 0.0f;
+                segmentDirY.back() = length > 0.0f ? dy / length : 0.0f;
+                arc += length;
+            }
+            pointX.push_back(p.x);
+            pointY.push_back(p.y);
+            pointArc.push_back(arc);
+            segmentDirX.push_back(0.0f);
+            segmentDirY.push_back(0.0f);
+        }
+        if (arc <= 0.0f)
+        {
+            size_t first = routeFirst.back();
+            for (auto* v : {&pointX, &pointY, &pointArc, &segmentDirX, &segmentDirY}) v->resize(first);
+            return -1;
+        }
+        routeFirst.push_back(static_cast<int>(pointX.size()));
+        return routeCount() - 1;
+    }
+
+    int addAircraft(int r, float unitsPerSecond, float startDistance = 0.0f)
+    {
+        int a = size();
+        route.push_back(r);
+        cursor.push_back(routeFirst[r]);
+        distance.push_back(startDistance);
+        speed.push_back(unitsPerSecond);
+        for (auto* v : {&originX, &originY, &originArc, &segmentEnd, &dirX, &dirY, &x, &y}) v->push_back(0.0f);
+        moveCursor(a);
+        x[a] = originX[a] + dirX[a] * (distance[a] - originArc[a]);
+        y[a] = originY[a] + dirY[a] * (distance[a] - originArc[a]);
+        return a;
+    }
+
+    void advance(float dt)
+    {
+        int n = size();
+        int i = 0;
+#if defined(__AVX2__)
+        const __m256 step = _mm256_set1_ps(dt);
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256 d = _mm256_add_ps(_mm256_loadu_ps(&distance[i]), _mm256_mul_ps(_mm256_loadu_ps(&speed[i]), step));
+            _mm256_storeu_ps(&distance[i], d);
+            crossed(i, _mm256_movemask_ps(_mm256_cmp_ps(d, _mm256_loadu_ps(&segmentEnd[i]), _CMP_GE_OQ)));
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        const __m128 step = _mm_set1_ps(dt);
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 d = _mm_add_ps(_mm_loadu_ps(&distance[i]), _mm_mul_ps(_mm_loadu_ps(&speed[i]), step));
+            _mm_storeu_ps(&distance[i], d);
+            crossed(i, _mm_movemask_ps(_mm_cmpge_ps(d, _mm_loadu_ps(&segmentEnd[i]))));
+        }
+#endif
+        for (; i < n; ++i)
+        {
+            distance[i] += speed[i] * dt;
+            if (distance[i] >= segmentEnd[i]) moveCursor(i);
+        }
+
+        i = 0;
+#if defined(__AVX2__)
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256 t = _mm256_sub_ps(_mm256_loadu_ps(&distance[i]), _mm256_loadu_ps(&originArc[i]));
+            _mm256_storeu_ps(&x[i], _mm256_add_ps(_mm256_loadu_ps(&originX[i]), _mm256_mul_ps(_mm256_loadu_ps(&dirX[i]), t)));
+            _mm256_storeu_ps(&y[i], _mm256_add_ps(_mm256_loadu_ps(&originY[i]), _mm256_mul_ps(_mm256_loadu_ps(&dirY[i]), t)));
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 t = _mm_sub_ps(_mm_loadu_ps(&distance[i]), _mm_loadu_ps(&originArc[i]));
+            _mm_storeu_ps(&x[i], _mm_add_ps(_mm_loadu_ps(&originX[i]), _mm_mul_ps(_mm_loadu_ps(&dirX[i]), t)));
+            _mm_storeu_ps(&y[i], _mm_add_ps(_mm_loadu_ps(&originY[i]), _mm_mul_ps(_mm_loadu_ps(&dirY[i]), t)));
+        }
+#endif
+        for (; i < n; ++i)
+        {
+            float t = distance[i] - originArc[i];
+            x[i] = originX[i] + dirX[i] * t;
+            y[i] = originY[i] + dirY[i] * t;
+        }
+    }
+
+private:
+    void crossed(int first, int lanes)
+    {
+        for (int lane = 0; lanes; ++lane, lanes >>= 1)
+            if (lanes & 1) moveCursor(first + lane);
+    }
+
+    // Moves aircraft a's cursor to the segment holding its distance,
+    // wrapping to the start of the route at the end.
+    void moveCursor(int a)
+    {
+        int first = routeFirst[route[a]], last = routeFirst[route[a] + 1] - 1;
+        float length = pointArc[last];
+        if (distance[a] >= length)
+        {
+            distance[a] = std::fmod(distance[a], length);
+            cursor[a] = first;
+        }
+        int c = cursor[a];
+        while (c + 1 < last && distance[a] >= pointArc[c + 1]) ++c;
+        cursor[a] = c;
+        originX[a] = pointX[c];
+        originY[a] = pointY[c];
+        originArc[a] = pointArc[c];
+        segmentEnd[a] = pointArc[c + 1];
+        dirX[a] = segmentDirX[c];
+        dirY[a] = segmentDirY[c];
+    }
+};
+
+// Adds count aircraft flying weather-aware routes between random airport
+// pairs, at random points along them and at speeds in [minSpeed,
+// maxSpeed]. Returns how many could be routed.
+inline int addRandomFlights(FleetKinematics& fleet, const FlightGraph& graph, int count, float minSpeed,
+                            float maxSpeed, unsigned seed, SearchMode mode = SearchMode::AStar)
+{
+    int n = graph.airportCount();
+    if (n < 2) return 0;
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> airport(0, n - 1);
+    std::uniform_real_distribution<float> fraction(0.0f, 1.0f);
+    GraphView view(graph);
+    std::vector<int> path;
+    int added = 0;
+    for (int k = 0; k < count; ++k)
+    {
+        int src = airport(rng), dst = airport(rng);
+        if (src == dst) continue;
+        view.shortestPath(src, dst, path, mode);
+        int r = fleet.addRoute(graph, path);
+        if (r < 0) continue;
+        fleet.addAircraft(r, minSpeed + (maxSpeed - minSpeed) * fraction(rng), fraction(rng) * fleet.routeLength(r));
+        ++added;
+    }
+    return added;
+}
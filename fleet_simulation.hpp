@@ -0,0 +1,170 @@
+#pragma once
+
+#include "fleet_kinematics.hpp"
+#include "triple_buffer.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+
+struct SimulationOptions
+{
+    double timestep = 1.0 / 120;    // simulated seconds per step
+    double timeScale = 1.0;         // simulated seconds per real second; 0 runs unpaced
+    double duration = 0.0;          // simulated seconds to run; 0 runs until stop()
+    int trackedAircraft = -1;       // whose leg snapshots report
+};
+
+// The fleet after one step, with its positions before the step, so a
+// renderer can draw any moment in between. An aircraft that looped back
+// to the start of its route has identical previous and current positions.
+struct FleetSnapshot
+{
+    std::uint64_t step = 0;
+    double time = 0.0;
+    std::chrono::steady_clock::time_point published;
+    double stepRealSeconds = 0.0;    // real time per step when paced, else 0
+    int trackedSegment = -1;
+    std::vector<float> previousX;
+    std::vector<float> previousY;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> dirX;
+    std::vector<float> dirY;
+
+    int size() const { return static_cast<int>(x.size()); }
+
+    // How far to blend from previous to current position at time now: the
+    // fraction of one step's real time since publication, at most 1.
+    float blend(std::chrono::steady_clock::time_point now) const
+    {
+        if (stepRealSeconds <= 0.0) return 1.0f;
+        double elapsed = std::chrono::duration<double>(now - published).count();
+        return static_cast<float>(std::min(1.0, std::max(0.0, elapsed / stepRealSeconds)));
+    }
+};
+
+// Advances a FleetKinematics on its own thread at a fixed timestep,
+// independent of any frame rate. Paced, step k runs at real time
+// k * timestep / timeScale after start (after a stall of more than a
+// quarter second the schedule restarts rather than catching up); unpaced,
+// steps run back to back, which is how a headless run goes faster than
+// real time. Every step is published as a FleetSnapshot through a triple
+// buffer, so the reader never blocks the simulation or the other way
+// round. The fleet belongs to the thread while it runs.
+struct FleetSimulation
+{
+    FleetSimulation(FleetKinematics& f, const SimulationOptions& o) : fleet(f), options(o) {}
+    ~FleetSimulation() { stop(); }
+
+    FleetSimulation(const FleetSimulation&) = delete;
+    FleetSimulation& operator=(const FleetSimulation&) = delete;
+
+    void start()
+    {
+        stopping = false;
+        finished = false;
+        worker = std::thread([this] { run(); });
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+    // Consumer side: true if a newer snapshot than the last one is there.
+    bool acquire() { return snapshots.acquire(); }
+    const FleetSnapshot& snapshot() const { return snapshots.readBuffer(); }
+
+    bool done() const { return finished.load(); }
+    std::uint64_t steps() const { return stepCount.load(); }
+
+private:
+    FleetKinematics& fleet;
+    SimulationOptions options;
+    TripleBuffer<FleetSnapshot> snapshots;
+    std::thread worker;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> finished{false};
+    std::atomic<std::uint64_t> stepCount{0};
+    std::vector<float> lastX, lastY, lastDistance;
+
+    void run()
+    {
+        using Clock = std::chrono::steady_clock;
+        const float dt = static_cast<float>(options.timestep);
+        const bool paced = options.timeScale > 0.0;
+        const auto stepReal = std::chrono::duration<double>(paced ? options.timestep / options.timeScale : 0.0);
+        const std::uint64_t lastStep = options.duration > 0.0
+            ? static_cast<std::uint64_t>(std::ceil(options.duration / options.timestep)) : ~std::uint64_t(0);
+        int n = fleet.size();
+        lastX.resize(n);
+        lastY.resize(n);
+        lastDistance.resize(n);
+
+        auto epoch = Clock::now();
+        std::uint64_t sinceEpoch = 0;
+        for (std::uint64_t step = 1; step <= lastStep; ++step)
+        {
+            if (paced)
+            {
+                auto due = epoch + std::chrono::duration_cast<Clock::duration>(stepReal * double(++sinceEpoch));
+                std::unique_lock<std::mutex> lock(sleepLock);
+                if (wake.wait_until(lock, due, [&] { return stopping.load(); })) break;
+                if (Clock::now() - due > std::chrono::milliseconds(250))
+                {
+                    epoch = Clock::now();
+                    sinceEpoch = 0;
+                }
+            }
+            else if (stopping.load())
+            {
+                break;
+            }
+
+            if (n > 0)
+            {
+                std::memcpy(lastX.data(), fleet.x.data(), n * sizeof(float));
+                std::memcpy(lastY.data(), fleet.y.data(), n * sizeof(float));
+                std::memcpy(lastDistance.data(), fleet.distance.data(), n * sizeof(float));
+            }
+            fleet.advance(dt);
+            publish(step, paced ? stepReal.count() : 0.0);
+            stepCount.store(step);
+        }
+        finished = true;
+    }
+
+    void publish(std::uint64_t step, double stepRealSeconds)
+    {
+        FleetSnapshot& s = snapshots.writeBuffer();
+        int n = fleet.size();
+        s.step = step;
+        s.time = step * options.timestep;
+        s.stepRealSeconds = stepRealSeconds;
+        s.trackedSegment = options.trackedAircraft >= 0 ? fleet.segment(options.trackedAircraft) : -1;
+        s.previousX.resize(n);
+        s.previousY.resize(n);
+        s.x.assign(fleet.x.begin(), fleet.x.end());
+        s.y.assign(fleet.y.begin(), fleet.y.end());
+        s.dirX.assign(fleet.dirX.begin(), fleet.dirX.end());
+        s.dirY.assign(fleet.dirY.begin(), fleet.dirY.end());
+        for (int a = 0; a < n; ++a)
+        {
+            bool looped = fleet.distance[a] < lastDistance[a];
+            s.previousX[a] = looped ? fleet.x[a] : lastX[a];
+            s.previousY[a] = looped ? fleet.y[a] : lastY[a];
+        }
+        s.published = std::chrono::steady_clock::now();
+        snapshots.publish();
+    }
+};
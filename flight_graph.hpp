@@ -0,0 +1,882 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <cstdint>
+#include <cmath>
+#include <array>
+#include <tuple>
+#include <memory>
+#include "priority_queues.hpp"
+#include "weather_layers.hpp"
+
+// Position on the simulator map. The routing code keeps its own type so it
+// builds without SFML; the simulator converts when drawing.
+struct MapPoint
+{
+    float x;
+    float y;
+};
+
+struct Airport
+{
+    std::string code;
+    MapPoint position;
+};
+
+struct WeatherCondition
+{
+    bool isBad;
+    std::string description;
+};
+
+// One edge's new weather; description is an interned id (see
+// FlightGraph::internDescription) and is ignored for good weather.
+struct WeatherUpdate
+{
+    int edge;
+    bool isBad;
+    std::uint32_t description;
+};
+
+enum class SearchMode
+{
+    Dijkstra,
+    AStar,
+    Bidirectional,
+    BidirectionalAStar
+};
+
+enum class QueueKind
+{
+    Lazy,
+    Quaternary,
+    Radix
+};
+
+struct SearchStats
+{
+    int settled = 0;
+    double distance = std::numeric_limits<double>::infinity();
+};
+
+// Distance/parent labels for one search direction. Entries are only valid
+// when their stamp equals the current generation, so reset() is O(1)
+// instead of clearing n entries before every query.
+struct SearchLabels
+{
+    std::vector<double> dist;
+    std::vector<int> prev;
+    std::vector<std::uint32_t> reached;
+    std::vector<std::uint32_t> settledAt;
+    std::uint32_t generation = 0;
+
+    void reset(int n)
+    {
+        if (static_cast<int>(reached.size()) < n)
+        {
+            dist.resize(n);
+            prev.resize(n);
+            reached.resize(n, 0);
+            settledAt.resize(n, 0);
+        }
+        if (++generation == 0)
+        {
+            std::fill(reached.begin(), reached.end(), 0);
+            std::fill(settledAt.begin(), settledAt.end(), 0);
+            generation = 1;
+        }
+    }
+
+    double distance(int v) const
+    {
+        return reached[v] == generation ? dist[v] : std::numeric_limits<double>::infinity();
+    }
+    int parent(int v) const { return reached[v] == generation ? prev[v] : -1; }
+    void set(int v, double d, int p)
+    {
+        dist[v] = d;
+        prev[v] = p;
+        reached[v] = generation;
+    }
+    bool isSettled(int v) const { return settledAt[v] == generation; }
+    void settle(int v) { settledAt[v] = generation; }
+};
+
+// Reusable scratch memory for the routing engines: labels and one queue of
+// each backend per search direction plus a stamped marker set. Once the arrays have grown
+// to the network size, a query performs no heap allocation. Engines borrow
+// the calling thread's instance through local() unless given one.
+struct SearchWorkspace
+{
+    SearchLabels labels[2];
+    std::tuple<std::array<LazyHeap, 2>, std::array<QuaternaryHeap, 2>, std::array<RadixHeap, 2>> queues;
+    std::vector<std::uint32_t> marked;
+    std::uint32_t markGeneration = 0;
+    std::vector<int> scratch;
+    std::vector<std::pair<int, int>> pairStack;
+
+    static SearchWorkspace& local()
+    {
+        thread_local SearchWorkspace workspace;
+        return workspace;
+    }
+
+    template <typename Queue>
+    Queue& queue(int side)
+    {
+        return std::get<std::array<Queue, 2>>(queues)[side];
+    }
+
+    template <typename Queue>
+    void begin(int n, int sides = 1)
+    {
+        for (int s = 0; s < sides; ++s)
+        {
+            labels[s].reset(n);
+            queue<Queue>(s).clear(n);
+        }
+    }
+
+    void beginMarks(int n)
+    {
+        if (static_cast<int>(marked.size()) < n) marked.resize(n, 0);
+        if (++markGeneration == 0)
+        {
+            std::fill(marked.begin(), marked.end(), 0);
+            markGeneration = 1;
+        }
+    }
+    bool isMarked(int v) const { return marked[v] == markGeneration; }
+    void mark(int v) { marked[v] = markGeneration; }
+    void unmark(int v) { marked[v] = 0; }
+};
+
+inline bool parseSearchMode(const std::string& name, SearchMode& mode)
+{
+    if (name == "dijkstra") mode = SearchMode::Dijkstra;
+    else if (name == "astar") mode = SearchMode::AStar;
+    else if (name == "bidir") mode = SearchMode::Bidirectional;
+    else if (name == "bidir-astar") mode = SearchMode::BidirectionalAStar;
+    else return false;
+    return true;
+}
+
+inline bool parseQueueKind(const std::string& name, QueueKind& kind)
+{
+    if (name == "lazy") kind = QueueKind::Lazy;
+    else if (name == "4ary") kind = QueueKind::Quaternary;
+    else if (name == "radix") kind = QueueKind::Radix;
+    else return false;
+    return true;
+}
+
+// Contiguous array that either owns its elements or refers to memory owned
+// elsewhere, such as a mapped graph snapshot. Reads look like a vector;
+// growing a borrowed array first copies it. Copies always own their data.
+template <typename T>
+struct GraphArray
+{
+    GraphArray() = default;
+    GraphArray(const GraphArray& other) : owned(other.begin(), other.end()) { sync(); }
+    GraphArray(GraphArray&& other) noexcept { *this = std::move(other); }
+
+    GraphArray& operator=(const GraphArray& other)
+    {
+        if (this != &other)
+        {
+            owned.assign(other.begin(), other.end());
+            sync();
+        }
+        return *this;
+    }
+
+    GraphArray& operator=(GraphArray&& other) noexcept
+    {
+        owned = std::move(other.owned);
+        items = other.items;
+        count = other.count;
+        other.owned.clear();
+        other.sync();
+        return *this;
+    }
+
+    // Refers to count elements at p; the caller keeps them alive.
+    void borrow(T* p, size_t n)
+    {
+        owned.clear();
+        owned.shrink_to_fit();
+        items = p;
+        count = n;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T* data() { return items; }
+    const T* data() const { return items; }
+    T* begin() { return items; }
+    T* end() { return items + count; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+    T& operator[](size_t i) { return items[i]; }
+    const T& operator[](size_t i) const { return items[i]; }
+
+    void push_back(const T& value)
+    {
+        own();
+        owned.push_back(value);
+        sync();
+    }
+
+    void reserve(size_t n)
+    {
+        own();
+        owned.reserve(n);
+        sync();
+    }
+
+    void assign(size_t n, const T& value)
+    {
+        owned.assign(n, value);
+        sync();
+    }
+
+private:
+    std::vector<T> owned;
+    T* items = nullptr;
+    size_t count = 0;
+
+    void sync()
+    {
+        items = owned.data();
+        count = owned.size();
+    }
+
+    void own()
+    {
+        if (items != owned.data())
+        {
+            owned.assign(items, items + count);
+            sync();
+        }
+    }
+};
+
+// Airports plus an undirected edge list. Every per-edge array is indexed by
+// edge id; finalize() packs the edges into a CSR adjacency so the routing
+// code never touches an n x n structure.
+struct FlightGraph
+{
+    std::vector<Airport> airports;
+
+    GraphArray<int> edgeFrom;
+    GraphArray<int> edgeTo;
+    GraphArray<double> edgeWeight;
+
+    // Weather, packed one bit per edge. hazardBits holds kHazardCount layers
+    // of weatherWords() words each; availableBits is their combined
+    // complement, so an edge is available when no hazard covers it.
+    GraphArray<std::uint64_t> hazardBits;
+    GraphArray<std::uint64_t> availableBits;
+    // Description given for an edge's bad weather, as an index into the
+    // interned weatherDescriptions (0 is "Clear"); descriptionIndex maps
+    // each back to its id.
+    GraphArray<std::uint32_t> edgeDescription;
+    std::vector<std::string> weatherDescriptions{"Clear"};
+    std::vector<Hazard> descriptionHazard{Hazard::Other};
+    std::unordered_map<std::string, std::uint32_t> descriptionIndex{{"Clear", 0}};
+    static const size_t kMaxDescriptions = 1 << 16;
+
+    // Arcs leaving airport u live in [arcOffset[u], arcOffset[u + 1]),
+    // sorted by arcTarget. Each undirected edge yields two arcs.
+    GraphArray<int> arcOffset;
+    GraphArray<int> arcTarget;
+    GraphArray<int> arcEdge;
+    GraphArray<double> arcWeight;
+
+    // Largest factor k with k * |pos(u) - pos(v)| <= weight(u, v) on every
+    // edge, so k times the straight-line distance is an admissible and
+    // consistent A* heuristic whatever units the weights are in.
+    double heuristicScale = 0.0;
+
+    // Keeps borrowed arrays alive (see loadGraphSnapshot).
+    std::shared_ptr<void> storage;
+
+    void addAirport(const std::string& code, float x, float y)
+    {
+        airports.push_back({code, {x, y}});
+    }
+
+    int addEdge(int u, int v, double dist)
+    {
+        edgeFrom.push_back(u);
+        edgeTo.push_back(v);
+        edgeWeight.push_back(dist);
+        edgeDescription.push_back(0);
+        return static_cast<int>(edgeFrom.size()) - 1;
+    }
+
+    void reserveEdges(size_t count)
+    {
+        edgeFrom.reserve(count);
+        edgeTo.reserve(count);
+        edgeWeight.reserve(count);
+        edgeDescription.reserve(count);
+    }
+
+    // Builds the CSR arrays from the edge list. Must be called after the
+    // last addAirport/addEdge and before any lookup or search.
+    void finalize()
+    {
+        int n = airportCount();
+        int m = edgeCount();
+
+        hazardBits.assign(kHazardCount * weatherWords(), 0);
+        availableBits.assign(weatherWords(), ~std::uint64_t(0));
+
+        arcOffset.assign(n + 1, 0);
+        for (int e = 0; e < m; ++e)
+        {
+            ++arcOffset[edgeFrom[e] + 1];
+            ++arcOffset[edgeTo[e] + 1];
+        }
+        for (int u = 0; u < n; ++u)
+            arcOffset[u + 1] += arcOffset[u];
+
+        arcTarget.assign(2 * m, 0);
+        arcEdge.assign(2 * m, 0);
+        arcWeight.assign(2 * m, 0.0);
+
+        std::vector<int> cursor(arcOffset.begin(), arcOffset.end() - 1);
+        for (int e = 0; e < m; ++e)
+        {
+            int a = cursor[edgeFrom[e]]++;
+            arcTarget[a] = edgeTo[e];
+            arcEdge[a] = e;
+            int b = cursor[edgeTo[e]]++;
+            arcTarget[b] = edgeFrom[e];
+            arcEdge[b] = e;
+        }
+
+        std::vector<std::pair<int, int>> row;
+        for (int u = 0; u < n; ++u)
+        {
+            row.clear();
+            for (int a = arcOffset[u]; a < arcOffset[u + 1]; ++a)
+                row.push_back({arcTarget[a], arcEdge[a]});
+            std::sort(row.begin(), row.end());
+            for (size_t k = 0; k < row.size(); ++k)
+            {
+                int a = arcOffset[u] + static_cast<int>(k);
+                arcTarget[a] = row[k].first;
+                arcEdge[a] = row[k].second;
+                arcWeight[a] = edgeWeight[row[k].second];
+            }
+        }
+
+        heuristicScale = std::numeric_limits<double>::infinity();
+        for (int e = 0; e < m; ++e)
+        {
+            double straight = straightLineDistance(edgeFrom[e], edgeTo[e]);
+            if (straight > 0.0)
+                heuristicScale = std::min(heuristicScale, edgeWeight[e] / straight);
+        }
+        if (!std::isfinite(heuristicScale)) heuristicScale = 0.0;
+        heuristicScale *= 1.0 - 1e-9;
+    }
+
+    double straightLineDistance(int u, int v) const
+    {
+        double dx = static_cast<double>(airports[u].position.x) - airports[v].position.x;
+        double dy = static_cast<double>(airports[u].position.y) - airports[v].position.y;
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    int airportCount() const { return static_cast<int>(airports.size()); }
+    int edgeCount() const { return static_cast<int>(edgeFrom.size()); }
+
+    // Edge id connecting u and v, or -1 if they are not adjacent.
+    int findEdge(int u, int v) const
+    {
+        auto first = arcTarget.begin() + arcOffset[u];
+        auto last = arcTarget.begin() + arcOffset[u + 1];
+        auto it = std::lower_bound(first, last, v);
+        if (it == last || *it != v) return -1;
+        return arcEdge[it - arcTarget.begin()];
+    }
+
+    bool isEdgeBad(int u, int v) const
+    {
+        int e = findEdge(u, v);
+        return e >= 0 && !isAvailable(e);
+    }
+
+    size_t weatherWords() const { return edgeWords(edgeCount()); }
+
+    bool isAvailable(int e) const { return availableBits[e >> 6] >> (e & 63) & 1; }
+
+    bool hasHazard(Hazard hazard, int e) const
+    {
+        return hazardBits[static_cast<int>(hazard) * weatherWords() + (e >> 6)] >> (e & 63) & 1;
+    }
+
+    // The description given for the edge if its hazard is still active,
+    // otherwise the name of its first active hazard.
+    WeatherCondition weatherOf(int e) const
+    {
+        if (isAvailable(e)) return {false, weatherDescriptions[0]};
+        std::uint32_t id = edgeDescription[e];
+        if (id != 0 && hasHazard(descriptionHazard[id], e)) return {true, weatherDescriptions[id]};
+        for (int h = 0; h < kHazardCount; ++h)
+            if (hasHazard(static_cast<Hazard>(h), e)) return {true, hazardName(static_cast<Hazard>(h))};
+        return {true, hazardName(Hazard::Other)};
+    }
+
+    // The id of description, added if new. Once kMaxDescriptions are
+    // interned a new one is stored as its hazard's name instead, so a
+    // long-running feed of free-text bulletins cannot grow the table forever.
+    std::uint32_t internDescription(std::string_view description)
+    {
+        std::string key(description);
+        auto it = descriptionIndex.find(key);
+        if (it != descriptionIndex.end()) return it->second;
+        Hazard hazard = classifyHazard(key);
+        if (weatherDescriptions.size() >= kMaxDescriptions)
+        {
+            key = hazardName(hazard);
+            it = descriptionIndex.find(key);
+            if (it != descriptionIndex.end()) return it->second;
+        }
+        std::uint32_t id = static_cast<std::uint32_t>(weatherDescriptions.size());
+        descriptionIndex.emplace(key, id);
+        weatherDescriptions.push_back(std::move(key));
+        descriptionHazard.push_back(hazard);
+        return id;
+    }
+
+    // Bad weather sets the edge's bit in the layer its description maps to;
+    // good weather clears it from every layer. Returns the id of the updated
+    // edge, or -1 if u and v are not adjacent.
+    int updateWeather(int u, int v, bool isBad, const std::string& description)
+    {
+        int e = findEdge(u, v);
+        if (e < 0) return -1;
+        size_t stride = weatherWords();
+        size_t word = e >> 6;
+        std::uint64_t bit = std::uint64_t(1) << (e & 63);
+        if (isBad)
+        {
+            std::uint32_t id = internDescription(description);
+            edgeDescription[e] = id;
+            hazardBits[static_cast<int>(descriptionHazard[id]) * stride + word] |= bit;
+        }
+        else
+        {
+            edgeDescription[e] = 0;
+            for (int h = 0; h < kHazardCount; ++h)
+                hazardBits[h * stride + word] &= ~bit;
+        }
+        combineHazardLayers(hazardBits.data(), stride, kHazardCount, availableBits.data(), word, word + 1);
+        return e;
+    }
+
+    // Replaces a whole hazard layer, e.g. from a weather bulletin, in time
+    // proportional to the number of words. Edges whose availability flipped
+    // are appended to changed if given.
+    void setHazardLayer(Hazard hazard, const EdgeMask& mask, std::vector<int>* changed = nullptr)
+    {
+        size_t stride = weatherWords();
+        std::uint64_t* layer = hazardBits.data() + static_cast<int>(hazard) * stride;
+        std::copy(mask.words.begin(), mask.words.begin() + std::min(stride, mask.words.size()), layer);
+        std::fill(layer + std::min(stride, mask.words.size()), layer + stride, 0);
+        if (stride > 0) layer[stride - 1] &= edgeTailMask(edgeCount());
+
+        if (!changed)
+        {
+            combineHazardLayers(hazardBits.data(), stride, kHazardCount, availableBits.data(), 0, stride);
+            return;
+        }
+        std::vector<std::uint64_t> before(availableBits.begin(), availableBits.end());
+        combineHazardLayers(hazardBits.data(), stride, kHazardCount, availableBits.data(), 0, stride);
+        for (size_t w = 0; w < stride; ++w)
+        {
+            for (std::uint64_t diff = before[w] ^ availableBits[w]; diff; diff &= diff - 1)
+                changed->push_back(static_cast<int>(w * 64 + lowestSetBit(diff)));
+        }
+    }
+
+    // Applies a batch of updates with the same meaning as updateWeather, as
+    // one step: the layers are edited first and the availability mask is
+    // recombined once per touched word, so a reader between two batches
+    // never sees part of one. Edges whose availability flipped are appended
+    // to changed if given.
+    void applyWeatherUpdates(const std::vector<WeatherUpdate>& updates, std::vector<int>* changed = nullptr)
+    {
+        size_t stride = weatherWords();
+        std::vector<size_t> touched;
+        touched.reserve(updates.size());
+        for (const WeatherUpdate& update : updates)
+        {
+            int e = update.edge;
+            size_t word = e >> 6;
+            std::uint64_t bit = std::uint64_t(1) << (e & 63);
+            if (update.isBad)
+            {
+                edgeDescription[e] = update.description;
+                hazardBits[static_cast<int>(descriptionHazard[update.description]) * stride + word] |= bit;
+            }
+            else
+            {
+                edgeDescription[e] = 0;
+                for (int h = 0; h < kHazardCount; ++h)
+                    hazardBits[h * stride + word] &= ~bit;
+            }
+            touched.push_back(word);
+        }
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+        for (size_t word : touched)
+        {
+            std::uint64_t before = availableBits[word];
+            combineHazardLayers(hazardBits.data(), stride, kHazardCount, availableBits.data(), word, word + 1);
+            if (!changed) continue;
+            for (std::uint64_t diff = before ^ availableBits[word]; diff; diff &= diff - 1)
+                changed->push_back(static_cast<int>(word * 64 + lowestSetBit(diff)));
+        }
+    }
+
+    // Edge ids along path; pairs that are not adjacent are left out.
+    void pathEdges(const std::vector<int>& path, std::vector<int>& edges) const
+    {
+        edges.clear();
+        for (size_t i = 0; i + 1 < path.size(); ++i)
+        {
+            int e = findEdge(path[i], path[i + 1]);
+            if (e >= 0) edges.push_back(e);
+        }
+    }
+
+    bool hasBadWeather(const std::vector<int>& path) const
+    {
+        std::vector<int> edges;
+        pathEdges(path, edges);
+        return anyEdgeUnavailable(availableBits.data(), edges.data(), edges.size());
+    }
+
+    std::vector<std::pair<std::string, std::string>> getPathWeatherInfo(const std::vector<int>& path) const
+    {
+        std::vector<std::pair<std::string, std::string>> result;
+        for (size_t i = 0; i + 1 < path.size(); ++i)
+        {
+            int u = path[i];
+            int v = path[i + 1];
+            int e = findEdge(u, v);
+            if (e >= 0 && !isAvailable(e))
+            {
+                result.push_back({airports[u].code + "-" + airports[v].code, weatherOf(e).description});
+            }
+        }
+        return result;
+    }
+
+    std::vector<int> dijkstra(int src, int dst) const;
+    std::vector<int> shortestPath(int src, int dst, SearchMode mode = SearchMode::Dijkstra, SearchStats* stats = nullptr) const;
+    std::vector<int> findRouteWithWeatherRerouting(int src, int dst, bool& rerouted) const;
+};
+
+// The stock 15-airport network, fully connected.
+inline FlightGraph makeDefaultNetwork()
+{
+    FlightGraph graph;
+
+    graph.addAirport("JFK", 150, 100);
+    graph.addAirport("LAX", 50, 500);
+    graph.addAirport("ORD", 350, 150);
+    graph.addAirport("DFW", 450, 350);
+    graph.addAirport("ATL", 300, 300);
+    graph.addAirport("SFO", 100, 450);
+    graph.addAirport("MIA", 250, 550);
+    graph.addAirport("SEA", 50, 50);
+    graph.addAirport("DEN", 300, 200);
+    graph.addAirport("BOS", 200, 80);
+    graph.addAirport("LAS", 150, 450);
+    graph.addAirport("PHX", 350, 450);
+    graph.addAirport("IAH", 500, 400);
+    graph.addAirport("EWR", 180, 90);
+    graph.addAirport("CLT", 330, 280);
+
+    int n = graph.airportCount();
+    graph.reserveEdges(static_cast<size_t>(n) * (n - 1) / 2);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = i + 1; j < n; ++j)
+        {
+            const auto& pi = graph.airports[i].position;
+            const auto& pj = graph.airports[j].position;
+            double dx = pi.x - pj.x;
+            double dy = pi.y - pj.y;
+            double dist = std::sqrt(dx * dx + dy * dy);
+            graph.addEdge(i, j, dist);
+        }
+    }
+    graph.finalize();
+    return graph;
+}
+
+// A what-if scenario over a FlightGraph: the base graph is shared, only the
+// edges whose availability differs are stored. Building a view costs
+// O(changed edges) regardless of network size. Views that change many
+// edges can point availableBits at their own packed availability (laid
+// out like FlightGraph::availableBits) instead, which replaces the graph's
+// weather and is as fast to check.
+struct GraphView
+{
+    const FlightGraph* graph;
+    bool ignoreWeather = false;
+    std::vector<std::pair<int, std::uint8_t>> overrides;
+    const std::uint64_t* availableBits = nullptr;
+
+    explicit GraphView(const FlightGraph& base) : graph(&base) {}
+
+    void setEdgeAvailable(int e, bool available)
+    {
+        auto it = std::lower_bound(overrides.begin(), overrides.end(), std::make_pair(e, std::uint8_t(0)));
+        if (it != overrides.end() && it->first == e)
+            it->second = available;
+        else
+            overrides.insert(it, {e, static_cast<std::uint8_t>(available)});
+    }
+
+    void closeEdge(int u, int v)
+    {
+        int e = graph->findEdge(u, v);
+        if (e >= 0) setEdgeAvailable(e, false);
+    }
+
+    bool isAvailable(int e) const
+    {
+        if (!overrides.empty())
+        {
+            auto it = std::lower_bound(overrides.begin(), overrides.end(), std::make_pair(e, std::uint8_t(0)));
+            if (it != overrides.end() && it->first == e) return it->second;
+        }
+        if (ignoreWeather) return true;
+        return availableBits ? availableBits[e >> 6] >> (e & 63) & 1 : graph->isAvailable(e);
+    }
+
+    std::vector<int> dijkstra(int src, int dst) const
+    {
+        return shortestPath(src, dst, SearchMode::Dijkstra);
+    }
+
+    std::vector<int> shortestPath(int src, int dst, SearchMode mode = SearchMode::Dijkstra, SearchStats* stats = nullptr) const
+    {
+        std::vector<int> path;
+        shortestPath(src, dst, path, mode, stats);
+        return path;
+    }
+
+    // Writes the route into path (left empty when dst is unreachable),
+    // reusing its capacity. Queue picks the priority-queue backend.
+    template <typename Queue = LazyHeap>
+    void shortestPath(int src, int dst, std::vector<int>& path, SearchMode mode, SearchStats* stats = nullptr,
+                      SearchWorkspace& ws = SearchWorkspace::local()) const
+    {
+        SearchStats local;
+        SearchStats& st = stats ? *stats : local;
+        st = SearchStats();
+        path.clear();
+
+        switch (mode)
+        {
+            case SearchMode::AStar: unidirectional<Queue>(src, dst, true, st, ws, path); break;
+            case SearchMode::Bidirectional: bidirectional<Queue>(src, dst, false, st, ws, path); break;
+            case SearchMode::BidirectionalAStar: bidirectional<Queue>(src, dst, true, st, ws, path); break;
+            default: unidirectional<Queue>(src, dst, false, st, ws, path); break;
+        }
+    }
+
+    void shortestPath(int src, int dst, std::vector<int>& path, SearchMode mode, QueueKind queue,
+                      SearchStats* stats = nullptr) const
+    {
+        switch (queue)
+        {
+            case QueueKind::Quaternary: shortestPath<QuaternaryHeap>(src, dst, path, mode, stats); break;
+            case QueueKind::Radix: shortestPath<RadixHeap>(src, dst, path, mode, stats); break;
+            default: shortestPath<LazyHeap>(src, dst, path, mode, stats); break;
+        }
+    }
+
+private:
+    // Plain Dijkstra when useHeuristic is false, A* towards dst otherwise.
+    template <typename Queue>
+    void unidirectional(int src, int dst, bool useHeuristic, SearchStats& st, SearchWorkspace& ws, std::vector<int>& path) const
+    {
+        const FlightGraph& g = *graph;
+        double scale = useHeuristic ? g.heuristicScale : 0.0;
+        SearchLabels& labels = ws.labels[0];
+        Queue& queue = ws.queue<Queue>(0);
+        ws.begin<Queue>(g.airportCount());
+        labels.set(src, 0, -1);
+        queue.push(scale * g.straightLineDistance(src, dst), src);
+
+        while (!queue.empty()) {
+            int u = queue.pop().second;
+            if (labels.isSettled(u)) continue;
+            labels.settle(u);
+            ++st.settled;
+            if (u == dst) break;
+
+            double d = labels.dist[u];
+            for (int a = g.arcOffset[u]; a < g.arcOffset[u + 1]; ++a)
+            {
+                if (!isAvailable(g.arcEdge[a])) continue;
+
+                int v = g.arcTarget[a];
+                double alt = d + g.arcWeight[a];
+                if (alt < labels.distance(v))
+                {
+                    labels.set(v, alt, u);
+                    queue.push(alt + scale * g.straightLineDistance(v, dst), v);
+                }
+            }
+        }
+
+        st.distance = labels.distance(dst);
+        if (st.distance == std::numeric_limits<double>::infinity()) return;
+        for (int at = dst; at != -1; at = labels.prev[at])
+            path.push_back(at);
+        std::reverse(path.begin(), path.end());
+    }
+
+    // Bidirectional Dijkstra, or bidirectional A* with the average potential
+    // p(v) = (h_dst(v) - h_src(v)) / 2. The backward search uses -p, so both
+    // searches see the same reduced costs and the usual stopping rule
+    // (top_forward + top_backward >= best) stays exact.
+    template <typename Queue>
+    void bidirectional(int src, int dst, bool useHeuristic, SearchStats& st, SearchWorkspace& ws, std::vector<int>& path) const
+    {
+        const FlightGraph& g = *graph;
+        double scale = useHeuristic ? 0.5 * g.heuristicScale : 0.0;
+        auto potential = [&](int v) {
+            return scale * (g.straightLineDistance(v, dst) - g.straightLineDistance(v, src));
+        };
+
+        const double inf = std::numeric_limits<double>::infinity();
+        Queue* queue[2] = {&ws.queue<Queue>(0), &ws.queue<Queue>(1)};
+        ws.begin<Queue>(g.airportCount(), 2);
+        ws.labels[0].set(src, 0, -1);
+        ws.labels[1].set(dst, 0, -1);
+        queue[0]->push(potential(src), src);
+        queue[1]->push(-potential(dst), dst);
+
+        double best = src == dst ? 0.0 : inf;
+        int meet = src == dst ? src : -1;
+
+        while (!queue[0]->empty() && !queue[1]->empty())
+        {
+            double top0 = queue[0]->topKey(), top1 = queue[1]->topKey();
+            if (top0 + top1 >= best) break;
+
+            int side = top0 <= top1 ? 0 : 1;
+            double sign = side == 0 ? 1.0 : -1.0;
+            SearchLabels& mine = ws.labels[side];
+            const SearchLabels& other = ws.labels[1 - side];
+            int u = queue[side]->pop().second;
+            if (mine.isSettled(u)) continue;
+            mine.settle(u);
+            ++st.settled;
+
+            double d = mine.dist[u];
+            for (int a = g.arcOffset[u]; a < g.arcOffset[u + 1]; ++a)
+            {
+                if (!isAvailable(g.arcEdge[a])) continue;
+
+                int v = g.arcTarget[a];
+                double alt = d + g.arcWeight[a];
+                if (alt < mine.distance(v))
+                {
+                    mine.set(v, alt, u);
+                    queue[side]->push(alt + sign * potential(v), v);
+                }
+                double through = alt + other.distance(v);
+                if (through < best)
+                {
+                    best = through;
+                    meet = v;
+                }
+            }
+        }
+
+        st.distance = best;
+        if (meet < 0) return;
+
+        for (int at = meet; at != -1; at = ws.labels[0].parent(at))
+            path.push_back(at);
+        std::reverse(path.begin(), path.end());
+        for (int at = ws.labels[1].parent(meet); at != -1; at = ws.labels[1].parent(at))
+            path.push_back(at);
+    }
+};
+
+inline std::vector<int> FlightGraph::dijkstra(int src, int dst) const
+{
+    return GraphView(*this).dijkstra(src, dst);
+}
+
+inline std::vector<int> FlightGraph::shortestPath(int src, int dst, SearchMode mode, SearchStats* stats) const
+{
+    return GraphView(*this).shortestPath(src, dst, mode, stats);
+}
+
+inline std::vector<int> FlightGraph::findRouteWithWeatherRerouting(int src, int dst, bool& rerouted) const
+{
+    std::vector<int> originalPath = dijkstra(src, dst);
+
+    if (originalPath.empty() || !hasBadWeather(originalPath))
+    {
+        rerouted = false;
+        return originalPath;
+    }
+
+    rerouted = true;
+
+    GraphView scenario(*this);
+    for (size_t i = 0; i + 1 < originalPath.size(); ++i)
+    {
+        int e = findEdge(originalPath[i], originalPath[i + 1]);
+        if (e >= 0 && !isAvailable(e)) {
+            scenario.setEdgeAvailable(e, false);
+        }
+    }
+
+    return scenario.dijkstra(src, dst);
+}
+
+// Fingerprint of a network's airports and legs (FNV-1a over the airport
+// codes and each edge's endpoints), so two processes can check that they
+// loaded the same one. Weather does not enter into it.
+inline std::uint64_t networkFingerprint(const FlightGraph& graph)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](std::uint64_t value) {
+        for (int i = 0; i < 8; ++i, value >>= 8)
+            hash = (hash ^ (value & 0xff)) * 1099511628211ull;
+    };
+    mix(graph.airports.size());
+    for (const Airport& airport : graph.airports)
+    {
+        for (char c : airport.code) mix(static_cast<unsigned char>(c));
+        mix(0);
+    }
+    mix(static_cast<std::uint64_t>(graph.edgeCount()));
+    for (int e = 0; e < graph.edgeCount(); ++e)
+        mix(static_cast<std::uint64_t>(graph.edgeFrom[e]) << 32 | static_cast<std::uint32_t>(graph.edgeTo[e]));
+    return hash;
+}
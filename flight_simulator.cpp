@@ -1,4 +1,9 @@
+// Building with -DAERO_HEADLESS leaves out the SFML visualization, so the
+// simulator builds and links without SFML (e.g. for --batch on servers).
+#ifndef AERO_HEADLESS
 #include <SFML/Graphics.hpp>
+#include "network_scene.hpp"
+#endif
 #include <iostream>
 #include <vector>
 #include <queue>
@@ -7,155 +12,27 @@
 #include <algorithm>
 #include <string>
 #include <cctype>
+#include <cstdlib>
 #include <iomanip>
 #include <ctime>
 #include <random>
 #include <chrono>
 #include <sstream>
-
-struct Airport 
-{
-    std::string code;
-    sf::Vector2f position;  
-};
-
-struct WeatherCondition 
-{
-    bool isBad;
-    std::string description;
-};
-
-struct FlightGraph 
-{
-    std::vector<Airport> airports;
-    std::vector<std::vector<std::pair<int, double>>> adj;  
-    std::vector<std::vector<bool>> pathAvailable; 
-    std::vector<std::vector<WeatherCondition>> pathWeather;  
-
-    void addAirport(const std::string& code, float x, float y) {
-        airports.push_back({code, {x, y}});
-        adj.emplace_back();
-
-        for (auto& row : pathAvailable) row.push_back(false);
-        pathAvailable.push_back(std::vector<bool>(airports.size(), false));
-        
-        for (auto& row : pathWeather) row.push_back({false, "Clear"});
-        pathWeather.push_back(std::vector<WeatherCondition>(airports.size(), {false, "Clear"}));
-    }
-
-    void addEdge(int u, int v, double dist) 
-    {
-        adj[u].emplace_back(v, dist);
-        adj[v].emplace_back(u, dist);
-        pathAvailable[u][v] = true;
-        pathAvailable[v][u] = true;
-        pathWeather[u][v] = {false, "Clear"};
-        pathWeather[v][u] = {false, "Clear"};
-    }
-    
-    void updateWeather(int u, int v, bool isBad, const std::string& description) 
-    {
-        pathWeather[u][v] = {isBad, description};
-        pathWeather[v][u] = {isBad, description};
-        pathAvailable[u][v] = !isBad;
-        pathAvailable[v][u] = !isBad;
-    }
-    
-    bool hasBadWeather(const std::vector<int>& path) const 
-    {
-        for (size_t i = 0; i < path.size() - 1; ++i) 
-        {
-            int u = path[i];
-            int v = path[i + 1];
-            if (pathWeather[u][v].isBad) 
-            {
-                return true;
-            }
-        }
-        return false;
-    }
-    std::vector<std::pair<std::string, std::string>> getPathWeatherInfo(const std::vector<int>& path) const 
-    {
-        std::vector<std::pair<std::string, std::string>> result;
-        for (size_t i = 0; i < path.size() - 1; ++i) 
-        {
-            int u = path[i];
-            int v = path[i + 1];
-            if (pathWeather[u][v].isBad) 
-            {
-                result.push_back({airports[u].code + "-" + airports[v].code, pathWeather[u][v].description});
-            }
-        }
-        return result;
-    }
-
-    std::vector<int> dijkstra(int src, int dst) const 
-    {
-        int n = adj.size();
-        std::vector<double> dist(n, std::numeric_limits<double>::infinity());
-        std::vector<int> prev(n, -1);
-        dist[src] = 0;
-    
-        using PDI = std::pair<double, int>;
-        std::priority_queue<PDI, std::vector<PDI>, std::greater<>> pq;
-        pq.push({0, src});
-    
-        while (!pq.empty()) {
-            auto [d, u] = pq.top(); pq.pop();
-            if (u == dst) break;
-            
-            for (auto [v, w] : adj[u]) 
-            {
-                if (!pathAvailable[u][v]) continue;  
-    
-                double alt = d + w;
-                if (alt < dist[v]) 
-                {
-                    dist[v] = alt;
-                    prev[v] = u;
-                    pq.push({alt, v});
-                }
-            }
-        }
-    
-        std::vector<int> path;
-        for (int at = dst; at != -1; at = prev[at])
-            path.push_back(at);
-        std::reverse(path.begin(), path.end());
-    
-        if (path.empty() || path.front() != src)
-            return {};
-        return path;
-    }
-    
-    std::vector<int> findRouteWithWeatherRerouting(int src, int dst, bool& rerouted) 
-    {
-        std::vector<int> originalPath = dijkstra(src, dst);
-        
-        if (originalPath.empty() || !hasBadWeather(originalPath)) 
-        {
-            rerouted = false;
-            return originalPath;
-        }
-        
-        rerouted = true;
-
-        FlightGraph tempGraph = *this;
-
-        for (size_t i = 0; i < originalPath.size() - 1; ++i) 
-        {
-            int u = originalPath[i];
-            int v = originalPath[i + 1];
-            if (pathWeather[u][v].isBad) {
-                
-                tempGraph.pathAvailable[u][v] = false;
-                tempGraph.pathAvailable[v][u] = false;
-            }
-        }
-        
-        return tempGraph.dijkstra(src, dst);
-    }
-};
+#include <set>
+#include "flight_graph.hpp"
+#include "contraction_hierarchy.hpp"
+#include "dynamic_routes.hpp"
+#include "network_loader.hpp"
+#include "graph_snapshot.hpp"
+#include "spatial_index.hpp"
+#include "weather_feed.hpp"
+#include "route_service.hpp"
+#include "fleet_simulation.hpp"
+#include "fleet_events.hpp"
+#include "weather_scenarios.hpp"
+#include "pareto_routes.hpp"
+#include "forecast_routing.hpp"
+#include <fstream>
 
 struct FlightTicket 
 {
@@ -264,7 +141,154 @@ int resolveAirportIndex(const std::string& input, const std::vector<Airport>& ai
     return -1;
 }
 
-void visualizeGraph(const FlightGraph& graph, const std::vector<int>& path, bool rerouted = false) 
+// Applies every epoch of the feed at path ("-" for stdin) to graph,
+// reporting each epoch's metrics to log.
+bool applyWeatherFeed(FlightGraph& graph, const std::string& path, RouteTracker* tracker, std::ostream& log) 
+{
+    std::ifstream feedFile;
+    if (path != "-") 
+    {
+        feedFile.open(path, std::ios::binary);
+        if (!feedFile) 
+        {
+            std::cerr << "Could not open weather feed " << path << std::endl;
+            return false;
+        }
+    }
+    WeatherFeedReader feed(path == "-" ? std::cin : feedFile, graph);
+    WeatherEpochStats epochStats;
+    std::vector<int> changedEdges;
+    long long received = 0;
+    while (feed.nextEpoch(epochStats, changedEdges)) 
+    {
+        if (tracker) 
+        {
+            for (int e : changedEdges) tracker->edgeChanged(e);
+        }
+        received += epochStats.received;
+        log << "Epoch " << epochStats.epoch << ": " << epochStats.received << " updates ("
+            << epochStats.applied << " after coalescing, " << epochStats.rejected << " rejected), "
+            << epochStats.changed << " edges changed, parse " << std::fixed << std::setprecision(1)
+            << epochStats.parseSeconds * 1e6 << " us, apply " << epochStats.applySeconds * 1e6 << " us, "
+            << std::setprecision(0) << epochStats.updatesPerSecond() << " updates/s" << std::endl;
+        log.unsetf(std::ios::floatfield);
+        log << std::setprecision(6);
+    }
+    log << "Weather feed: " << received << " updates in " << feed.epochs() << " epochs" << std::endl;
+    return true;
+}
+
+// Reads leg failure probabilities from path into failures, on top of its
+// default rate.
+bool readFailures(const FlightGraph& graph, const std::string& path, FailureModel& failures) 
+{
+    std::ifstream file(path);
+    std::string error;
+    if (!file) 
+    {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+    if (!readFailureProbabilities(file, graph, failures, error)) 
+    {
+        std::cerr << path << ", " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void printUsage(std::ostream& out) 
+{
+    out << "Usage: flight_simulator [options] [<src> <dst> [dijkstra|astar|bidir|bidir-astar|ch]]\n"
+           "\n"
+           "Network:\n"
+           "  --airports FILE, --routes FILE  OpenFlights dataset (default: built-in airports)\n"
+           "  --snapshot FILE                 binary graph snapshot, rebuilt when older than the dataset\n"
+           "  --nearest K                     link each built-in airport to its K nearest only\n"
+           "  --weather-feed FILE             weather updates from FILE (\"-\" for stdin) instead of prompting\n"
+           "\n"
+           "Batch routing (no window):\n"
+           "  --batch FILE                    answer the route queries in FILE (\"-\" for stdin)\n"
+           "  --output FILE                   write results to FILE (default stdout)\n"
+           "  --format json|binary            result format (default json)\n"
+           "  --mode MODE                     dijkstra (default), astar, bidir, bidir-astar or ch\n"
+           "  --threads N                     worker threads (default: all cores)\n"
+           "  --scenarios N                   rate each route's reliability over N random weather scenarios\n"
+           "  --failures FILE                 per-leg failure probabilities for --scenarios and --pareto\n"
+           "  --failure-rate P                failure probability of other legs (default 0.01)\n"
+           "  --seed S                        random seed for --scenarios (default 1)\n"
+           "  --pareto LIST                   every route not beaten on all of LIST (distance, risk, fare, legs)\n"
+           "  --max-labels N                  label limit per --pareto query\n"
+           "  --forecast FILE                 fastest route on a weather forecast (see forecast_routing.hpp)\n"
+           "  --depart HOUR                   departure hour for --forecast (default 0)\n"
+           "\n"
+           "Service:\n"
+           "  --serve PATH                    answer requests on a local socket until SHUTDOWN\n"
+           "\n"
+           "Fleet:\n"
+           "  --fleet N                       animate N more aircraft on random routes\n"
+           "  --timestep S                    simulation step in seconds (default 1/120)\n"
+           "  --time-scale X                  run X times real time\n"
+           "  --simulate S                    run the fleet (1000 aircraft by default) for S seconds, no window\n"
+           "  --events H                      discrete-event fleet simulation over H hours, rerouting on weather\n"
+           "  --weather-interval H            hours between weather epochs for --events (default 0.5)\n"
+           "\n"
+           "  --help                          show this message\n";
+}
+
+// Picks the batch mode from the options given: "" for plain routing, or
+// one of --scenarios, --pareto and --forecast. Fails, saying why, when
+// several are given, one is given without --batch, or an option is given
+// that the mode does not read.
+bool selectBatchMode(const std::set<std::string>& given, bool batch, std::string& mode) 
+{
+    mode.clear();
+    for (const char* option : {"--scenarios", "--pareto", "--forecast"}) 
+    {
+        if (!given.count(option)) continue;
+        if (!mode.empty()) 
+        {
+            std::cerr << mode << " and " << option << " cannot be combined" << std::endl;
+            return false;
+        }
+        mode = option;
+    }
+    if (!mode.empty() && !batch) 
+    {
+        std::cerr << mode << " answers the queries of --batch, which is missing" << std::endl;
+        return false;
+    }
+
+    // The modes that read each option, "" being plain routing; options it
+    // reads are also read outside batch mode.
+    const std::pair<const char*, std::vector<std::string>> readers[] = {
+        {"--format", {""}},
+        {"--threads", {"", "--scenarios"}},
+        {"--mode", {"", "--scenarios", "--forecast"}},
+        {"--failures", {"--scenarios", "--pareto"}},
+        {"--failure-rate", {"--scenarios", "--pareto"}},
+        {"--seed", {"--scenarios"}},
+        {"--max-labels", {"--pareto"}},
+        {"--depart", {"--forecast"}},
+    };
+    for (const auto& [option, modes] : readers) 
+    {
+        if (!given.count(option) || std::find(modes.begin(), modes.end(), mode) != modes.end()) continue;
+        if (mode.empty()) std::cerr << option << " only applies with " << modes.front() << std::endl;
+        else std::cerr << option << " does not apply to " << mode << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#ifndef AERO_HEADLESS
+sf::Vector2f toVector(const MapPoint& p) 
+{
+    return sf::Vector2f(p.x, p.y);
+}
+
+void visualizeGraph(const FlightGraph& graph, const std::vector<int>& path, bool rerouted = false, int fleetSize = 0,
+                    SimulationOptions simulation = SimulationOptions()) 
 {
     sf::RenderWindow window(sf::VideoMode(900, 650), "Flight Path Visualization");
     window.setFramerateLimit(60); 
@@ -282,8 +306,8 @@ void visualizeGraph(const FlightGraph& graph, const std::vector<int>& path, bool
     sf::Color pathColor = sf::Color::Yellow;
     sf::Color reroutedPathColor = sf::Color(255, 165, 0); 
     sf::Color planeColor = sf::Color::White;
+    sf::Color fleetColor = sf::Color(170, 200, 255);
     sf::Color waypointColor = sf::Color::Magenta; 
-    sf::Color badWeatherColor = sf::Color(255, 0, 0, 128); 
 
     std::cout << "\nVisualizing path: ";
     for (int idx : path) 
@@ -292,76 +316,16 @@ void visualizeGraph(const FlightGraph& graph, const std::vector<int>& path, bool
     }
     std::cout << "\n";
 
-    std::vector<sf::CircleShape> airportShapes;
-    std::vector<sf::Text> airportLabels;
-
-    for (size_t i = 0; i < graph.airports.size(); ++i) 
-    {
-        const auto& airport = graph.airports[i];
-        sf::CircleShape shape(8);
-        shape.setFillColor(airportColor);
-        shape.setPosition(airport.position);
-        airportShapes.push_back(shape);
-
-        sf::Text label;
-        label.setFont(font);
-        label.setString(airport.code);
-        label.setCharacterSize(14);
-        label.setFillColor(sf::Color::White);
-        label.setPosition(airport.position.x + 12, airport.position.y - 5);
-        airportLabels.push_back(label);
-    }
-
-    std::vector<sf::CircleShape> pathAirportShapes;
-    if (!path.empty()) 
-    {
-        for (size_t i = 0; i < path.size(); ++i) {
-            const auto& airport = graph.airports[path[i]];
-            sf::CircleShape shape(10); 
-            shape.setFillColor(waypointColor);
-            shape.setPosition(airport.position.x - 2, airport.position.y - 2); 
-            pathAirportShapes.push_back(shape);
-        }
-    }
+    NetworkScene scene;
+    scene.availableColor = availableColor;
+    scene.unavailableColor = unavailableColor;
+    scene.airportColor = airportColor;
+    scene.build(graph, font);
 
-    std::vector<sf::VertexArray> connectionLines;
-    std::vector<sf::VertexArray> badWeatherLines; 
-
-    std::vector<std::pair<int, int>> badWeatherPaths;
-
-    for (int i = 0; i < graph.airports.size(); ++i) 
+    std::vector<sf::Vertex> waypointDiscs;
+    for (int idx : path) 
     {
-        for (int j = i + 1; j < graph.airports.size(); ++j) 
-        {
-            sf::Color color;
-            bool isBadWeather = graph.pathWeather[i][j].isBad;
-            
-            if (isBadWeather) 
-            {    
-                sf::VertexArray badWeatherLine(sf::Lines, 2);
-                badWeatherLine[0] = sf::Vertex(graph.airports[i].position, badWeatherColor);
-                badWeatherLine[1] = sf::Vertex(graph.airports[j].position, badWeatherColor);
-                badWeatherLines.push_back(badWeatherLine);
-        
-                badWeatherPaths.push_back({i, j});
-                badWeatherPaths.push_back({j, i}); 
-                
-                color = unavailableColor;
-            } 
-            else if (!graph.pathAvailable[i][j]) 
-            {
-                color = sf::Color(150, 150, 150); 
-            }
-            else 
-            {
-                color = availableColor; 
-            }
-            
-            sf::VertexArray line(sf::Lines, 2);
-            line[0] = sf::Vertex(graph.airports[i].position, color);
-            line[1] = sf::Vertex(graph.airports[j].position, color);
-            connectionLines.push_back(line);
-        }
+        appendDisc(waypointDiscs, scene.airportCenter(graph.airports[idx].position), 10, waypointColor);
     }
 
     sf::Text statusText;
@@ -398,8 +362,7 @@ void visualizeGraph(const FlightGraph& graph, const std::vector<int>& path, bool
     pathText.setFillColor(sf::Color::White);
     pathText.setPosition(20, 50);
     
-    std::vector<sf::VertexArray> pathSegments;
-    std::vector<float> pathLengths;
+    std::vector<sf::Vertex> pathVertices;
     std::vector<std::pair<int, int>> pathPairs;
     float totalPathLength = 0.0f;
     
@@ -409,20 +372,18 @@ void visualizeGraph(const FlightGraph& graph, const std::vector<int>& path, bool
         {
             int fromIdx = path[i-1];
             int toIdx = path[i];
-            sf::Vector2f start = graph.airports[fromIdx].position;
-            sf::Vector2f end = graph.airports[toIdx].position;
+            sf::Vector2f start = toVector(graph.airports[fromIdx].position);
+            sf::Vector2f end = toVector(graph.airports[toIdx].position);
             
-            bool hasBadWeather = graph.pathWeather[fromIdx][toIdx].isBad;
+            bool hasBadWeather = graph.isEdgeBad(fromIdx, toIdx);
             
             float dx = end.x - start.x;
             float dy = end.y - start.y;
             float length = std::sqrt(dx*dx + dy*dy);
-            pathLengths.push_back(length);
             totalPathLength += length;
             
             pathPairs.push_back({fromIdx, toIdx});
             
-            sf::VertexArray segment(sf::Lines, 2);
             sf::Color actualPathColor;
             
             if (hasBadWeather) 
@@ -437,9 +398,8 @@ void visualizeGraph(const FlightGraph& graph, const std::vector<int>& path, bool
                 actualPathColor = pathColor;
             }
             
-            segment[0] = sf::Vertex(start, actualPathColor);
-            segment[1] = sf::Vertex(end, actualPathColor);
-            pathSegments.push_back(segment);
+            pathVertices.emplace_back(start, actualPathColor);
+            pathVertices.emplace_back(end, actualPathColor);
 
             std::cout << "Created path segment: " << graph.airports[fromIdx].code << " -> " 
                     << graph.airports[toIdx].code << " (length: " << length << ")";
@@ -453,102 +413,140 @@ void visualizeGraph(const FlightGraph& graph, const std::vector<int>& path, bool
         }
     }
     
-    sf::Clock clock;
-    float animationProgress = 0.0f;
     const float animationSpeed = 0.3f; 
-    
-    sf::CircleShape airplane(6, 3); 
-    airplane.setFillColor(planeColor);
-    airplane.setOrigin(6, 6); 
+
+    // The booked flight is aircraft 0 and covers animationSpeed of its
+    // path per second; --fleet adds that many more on random routes.
+    FleetKinematics fleet;
+    int focus = -1;
+    int pathRoute = fleet.addRoute(graph, path);
+    if (pathRoute >= 0) 
+    {
+        focus = fleet.addAircraft(pathRoute, animationSpeed * totalPathLength);
+    }
+    if (fleetSize > 0) 
+    {
+        int added = addRandomFlights(fleet, graph, fleetSize, 40.0f, 120.0f, 2024);
+        std::cout << "Fleet: " << added << " aircraft on random routes\n";
+    }
+    std::vector<sf::Vertex> aircraftVertices;
+
+    // The fleet moves on its own thread; frames draw its latest snapshot.
+    simulation.trackedAircraft = focus;
+    FleetSimulation simulator(fleet, simulation);
+    simulator.start();
+
+    sf::Text hintText;
+    hintText.setFont(font);
+    hintText.setString("Scroll or +/- to zoom, drag or arrows to pan, Home to reset, ESC to exit");
+    hintText.setCharacterSize(14);
+    hintText.setFillColor(sf::Color::White);
+    hintText.setPosition(20, 80);
+
+    // The map is drawn through camera, the text through hud. The wheel
+    // zooms about the cursor so the point under it stays put.
+    sf::View camera = window.getDefaultView();
+    sf::View hud = window.getDefaultView();
+    const sf::Vector2f homeCenter = camera.getCenter();
+    float zoom = 1.0f;
+    bool dragging = false;
+    sf::Vector2i dragFrom;
+
+    auto zoomAt = [&](sf::Vector2i pixel, float factor) 
+    {
+        factor = std::min(std::max(zoom * factor, 1.0f / 64), 16.0f) / zoom;
+        sf::Vector2f before = window.mapPixelToCoords(pixel, camera);
+        camera.zoom(factor);
+        zoom *= factor;
+        camera.move(before - window.mapPixelToCoords(pixel, camera));
+    };
     
     while (window.isOpen()) 
     {
         sf::Event event;
+        sf::Vector2u windowSize = window.getSize();
+        sf::Vector2i windowCenter(windowSize.x / 2, windowSize.y / 2);
         while (window.pollEvent(event))
+        {
             if (event.type == sf::Event::Closed)
                 window.close();
-        
-        float deltaTime = clock.restart().asSeconds();
-        if (!path.empty() && path.size() > 1) 
-        {
-            animationProgress += deltaTime * animationSpeed;
-            if (animationProgress > 1.0f) 
+            else if (event.type == sf::Event::Resized) 
             {
-                animationProgress = 0.0f; 
+                camera.setSize(event.size.width * zoom, event.size.height * zoom);
+                hud.reset(sf::FloatRect(0, 0, event.size.width, event.size.height));
             }
-        }
-        
-        window.clear();
-
-        for (const auto& line : connectionLines)
-            window.draw(line);
-            
-        for (const auto& line : badWeatherLines)
-            window.draw(line);
-
-        for (const auto& shape : airportShapes)
-            window.draw(shape);
-
-        for (const auto& shape : pathAirportShapes)
-            window.draw(shape);
-            
-        for (const auto& label : airportLabels)
-            window.draw(label);
-        if (!path.empty() && path.size() > 1) {
-            float distanceCovered = animationProgress * totalPathLength;
-            float accumulatedLength = 0.0f;
-            int currentSegment = -1;
-            float segmentProgress = 0.0f;
-            
-            for (size_t i = 0; i < pathLengths.size(); ++i) 
+            else if (event.type == sf::Event::MouseWheelScrolled && event.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel)
+                zoomAt(sf::Vector2i(event.mouseWheelScroll.x, event.mouseWheelScroll.y), event.mouseWheelScroll.delta > 0 ? 0.8f : 1.25f);
+            else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) 
             {
-                if (distanceCovered <= accumulatedLength + pathLengths[i]) 
-                {
-                    currentSegment = i;
-                    segmentProgress = (distanceCovered - accumulatedLength) / pathLengths[i];
-                    break;
-                }
-                accumulatedLength += pathLengths[i];
-            }
-            
-            if (currentSegment == -1) {
-                currentSegment = pathLengths.size() - 1;
-                segmentProgress = 1.0f;
+                dragging = true;
+                dragFrom = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
             }
-
-            for (int i = 0; i < currentSegment; ++i) 
+            else if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left)
+                dragging = false;
+            else if (event.type == sf::Event::MouseMoved && dragging) 
             {
-                window.draw(pathSegments[i]);
+                sf::Vector2i to(event.mouseMove.x, event.mouseMove.y);
+                camera.move(window.mapPixelToCoords(dragFrom, camera) - window.mapPixelToCoords(to, camera));
+                dragFrom = to;
             }
-
-            if (currentSegment < pathSegments.size()) 
+            else if (event.type == sf::Event::KeyPressed) 
             {
-                sf::VertexArray partialSegment = pathSegments[currentSegment];
-                sf::Vector2f start = partialSegment[0].position;
-                sf::Vector2f end = partialSegment[1].position;
-                sf::Vector2f partialEnd = start + (end - start) * segmentProgress;
-                
-                partialSegment[1].position = partialEnd;
-                window.draw(partialSegment);
-
-                airplane.setPosition(partialEnd);
-                float angle = std::atan2(end.y - start.y, end.x - start.x) * 180 / 3.14159f;
-                airplane.setRotation(angle + 90);
+                sf::Vector2f step = camera.getSize() * 0.1f;
+                switch (event.key.code) 
+                {
+                case sf::Keyboard::Add:
+                case sf::Keyboard::Equal: zoomAt(windowCenter, 0.8f); break;
+                case sf::Keyboard::Subtract:
+                case sf::Keyboard::Hyphen: zoomAt(windowCenter, 1.25f); break;
+                case sf::Keyboard::Left: camera.move(-step.x, 0); break;
+                case sf::Keyboard::Right: camera.move(step.x, 0); break;
+                case sf::Keyboard::Up: camera.move(0, -step.y); break;
+                case sf::Keyboard::Down: camera.move(0, step.y); break;
+                case sf::Keyboard::Home:
+                    zoom = 1.0f;
+                    camera.setCenter(homeCenter);
+                    camera.setSize(windowSize.x, windowSize.y);
+                    break;
+                default: break;
+                }
             }
+        }
+        
+        simulator.acquire();
+        const FleetSnapshot& snapshot = simulator.snapshot();
+        float blend = snapshot.blend(std::chrono::steady_clock::now());
+        
+        window.clear();
 
-            window.draw(airplane);
+        scene.cull(camera, static_cast<float>(windowSize.x));
+        window.setView(camera);
+        scene.drawNetwork(window);
+        if (!waypointDiscs.empty())
+            window.draw(waypointDiscs.data(), waypointDiscs.size(), sf::Triangles);
+        scene.drawLabels(window);
+        if (focus >= 0 && snapshot.trackedSegment >= 0) 
+        {
+            int currentSegment = snapshot.trackedSegment;
+            if (currentSegment > 0)
+                window.draw(pathVertices.data(), 2 * currentSegment, sf::Lines);
+
+            sf::Vertex partialSegment[2] = {pathVertices[2 * currentSegment], pathVertices[2 * currentSegment + 1]};
+            partialSegment[1].position = sf::Vector2f(
+                snapshot.previousX[focus] + (snapshot.x[focus] - snapshot.previousX[focus]) * blend,
+                snapshot.previousY[focus] + (snapshot.y[focus] - snapshot.previousY[focus]) * blend);
+            window.draw(partialSegment, 2, sf::Lines);
+        }
+        if (snapshot.size() > 0) 
+        {
+            fleetVertices(snapshot, blend, aircraftVertices, 6.0f, fleetColor, focus, planeColor);
+            window.draw(aircraftVertices.data(), aircraftVertices.size(), sf::Triangles);
         }
 
+        window.setView(hud);
         window.draw(statusText);
         window.draw(pathText);
-
-        sf::Text animText;
-        animText.setFont(font);
-        animText.setString("Press ESC to exit");
-        animText.setCharacterSize(14);
-        animText.setFillColor(sf::Color::White);
-        animText.setPosition(20, 80);
-        window.draw(animText);
+        window.draw(hintText);
         
         window.display();
 
@@ -556,15 +554,186 @@ void visualizeGraph(const FlightGraph& graph, const std::vector<int>& path, bool
             window.close();
     }
 }
+#endif
 
 
 int main(int argc, char* argv[]) {
     std::ios_base::sync_with_stdio(true); 
     
+    // Options are listed in printUsage; the remaining arguments are
+    // positional.
+    std::string airportsPath, routesPath, snapshotPath, weatherFeedPath;
+    std::string batchPath, outputPath, formatName = "json", modeName = "dijkstra", servePath;
+    std::string failuresPath, paretoList, forecastPath;
+    int nearestLinks = 0;
+    int fleetSize = 0;
+    double simulateSeconds = 0.0;
+    double eventHours = 0.0;
+    double weatherInterval = 0.5;
+    int scenarioCount = 0;
+    double failureRate = 0.01;
+    unsigned long long scenarioSeed = 1;
+    ParetoOptions pareto;
+    double departHour = 0.0;
+    SimulationOptions simulation;
+    bool timeScaleGiven = false;
+    bool modeGiven = false;
+    unsigned batchThreads = 0;
+    std::vector<char*> positional;
+    std::set<std::string> given;
+    for (int i = 0; i < argc; ++i) 
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") == 0 && i + 1 < argc) given.insert(arg);
+        if (arg == "--help" || arg == "-h") 
+        {
+            printUsage(std::cout);
+            return 0;
+        }
+        if (arg == "--airports" && i + 1 < argc) 
+        {
+            airportsPath = argv[++i];
+            continue;
+        }
+        if (arg == "--routes" && i + 1 < argc) 
+        {
+            routesPath = argv[++i];
+            continue;
+        }
+        if (arg == "--snapshot" && i + 1 < argc) 
+        {
+            snapshotPath = argv[++i];
+            continue;
+        }
+        if (arg == "--weather-feed" && i + 1 < argc) 
+        {
+            weatherFeedPath = argv[++i];
+            continue;
+        }
+        if (arg == "--batch" && i + 1 < argc) 
+        {
+            batchPath = argv[++i];
+            continue;
+        }
+        if (arg == "--serve" && i + 1 < argc) 
+        {
+            servePath = argv[++i];
+            continue;
+        }
+        if (arg == "--output" && i + 1 < argc) 
+        {
+            outputPath = argv[++i];
+            continue;
+        }
+        if (arg == "--format" && i + 1 < argc) 
+        {
+            formatName = argv[++i];
+            continue;
+        }
+        if (arg == "--mode" && i + 1 < argc) 
+        {
+            modeName = argv[++i];
+            modeGiven = true;
+            continue;
+        }
+        if (arg == "--threads" && i + 1 < argc) 
+        {
+            batchThreads = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+            continue;
+        }
+        if (arg == "--nearest" && i + 1 < argc) 
+        {
+            nearestLinks = std::max(0, std::atoi(argv[++i]));
+            continue;
+        }
+        if (arg == "--fleet" && i + 1 < argc) 
+        {
+            fleetSize = std::max(0, std::atoi(argv[++i]));
+            continue;
+        }
+        if (arg == "--simulate" && i + 1 < argc) 
+        {
+            simulateSeconds = std::atof(argv[++i]);
+            continue;
+        }
+        if (arg == "--events" && i + 1 < argc) 
+        {
+            eventHours = std::atof(argv[++i]);
+            continue;
+        }
+        if (arg == "--weather-interval" && i + 1 < argc) 
+        {
+            weatherInterval = std::atof(argv[++i]);
+            continue;
+        }
+        if (arg == "--scenarios" && i + 1 < argc) 
+        {
+            scenarioCount = std::max(0, std::atoi(argv[++i]));
+            continue;
+        }
+        if (arg == "--failures" && i + 1 < argc) 
+        {
+            failuresPath = argv[++i];
+            continue;
+        }
+        if (arg == "--failure-rate" && i + 1 < argc) 
+        {
+            failureRate = std::min(1.0, std::max(0.0, std::atof(argv[++i])));
+            continue;
+        }
+        if (arg == "--pareto" && i + 1 < argc) 
+        {
+            paretoList = argv[++i];
+            continue;
+        }
+        if (arg == "--max-labels" && i + 1 < argc) 
+        {
+            pareto.maxLabels = std::max(1, std::atoi(argv[++i]));
+            continue;
+        }
+        if (arg == "--forecast" && i + 1 < argc) 
+        {
+            forecastPath = argv[++i];
+            continue;
+        }
+        if (arg == "--depart" && i + 1 < argc) 
+        {
+            departHour = std::max(0.0, std::atof(argv[++i]));
+            continue;
+        }
+        if (arg == "--seed" && i + 1 < argc) 
+        {
+            scenarioSeed = std::strtoull(argv[++i], nullptr, 10);
+            continue;
+        }
+        if (arg == "--timestep" && i + 1 < argc) 
+        {
+            simulation.timestep = std::atof(argv[++i]);
+            continue;
+        }
+        if (arg == "--time-scale" && i + 1 < argc) 
+        {
+            simulation.timeScale = std::max(0.0, std::atof(argv[++i]));
+            timeScaleGiven = true;
+            continue;
+        }
+        positional.push_back(argv[i]);
+    }
+    argc = static_cast<int>(positional.size());
+    argv = positional.data();
+
     int src = -1, dst = -1;
     bool useCommandLineArgs = false;
+    SearchMode searchMode = SearchMode::Dijkstra;
+    bool useHierarchy = argc == 4 && std::string(argv[3]) == "ch";
     
-    if (argc == 3) 
+    if (argc == 4 && !useHierarchy && !parseSearchMode(argv[3], searchMode)) 
+    {
+        std::cerr << "Unknown search mode '" << argv[3] << "' (expected dijkstra, astar, bidir, bidir-astar or ch)" << std::endl;
+        return 1;
+    }
+    
+    if (argc == 3 || argc == 4) 
     {
         try {
             src = std::stoi(argv[1]);
@@ -577,36 +746,302 @@ int main(int argc, char* argv[]) {
         }
     }
     
+    BatchOptions batchOptions;
+    batchOptions.threads = batchThreads;
+    batchOptions.useHierarchy = modeName == "ch";
+    std::string batchMode;
+    if (!selectBatchMode(given, !batchPath.empty(), batchMode)) return 1;
+    if (batchOptions.useHierarchy && (batchMode == "--scenarios" || batchMode == "--forecast")) 
+    {
+        std::cerr << "Mode 'ch' does not apply to " << batchMode << std::endl;
+        return 1;
+    }
+    if (batchMode == "--scenarios" && scenarioCount <= 0) 
+    {
+        std::cerr << "--scenarios must be positive" << std::endl;
+        return 1;
+    }
+    if (!servePath.empty() && batchOptions.useHierarchy) 
+    {
+        std::cerr << "The routing service does not support mode 'ch'" << std::endl;
+        return 1;
+    }
+    if (!batchPath.empty() || !servePath.empty() || eventHours > 0.0) 
+    {
+        if (formatName == "binary") batchOptions.format = BatchFormat::Binary;
+        else if (formatName != "json") 
+        {
+            std::cerr << "Unknown format '" << formatName << "' (expected json or binary)" << std::endl;
+            return 1;
+        }
+        if (!batchOptions.useHierarchy && !parseSearchMode(modeName, batchOptions.mode)) 
+        {
+            std::cerr << "Unknown search mode '" << modeName << "' (expected dijkstra, astar, bidir, bidir-astar or ch)" << std::endl;
+            return 1;
+        }
+    }
+    if (!(simulation.timestep > 0.0)) 
+    {
+        std::cerr << "--timestep must be positive" << std::endl;
+        return 1;
+    }
+    // Results go to stdout in batch mode, so progress goes to stderr.
+    std::ostream& log = batchPath.empty() ? std::cout : std::cerr;
+
     FlightGraph graph;
+    if (airportsPath.empty() != routesPath.empty()) 
+    {
+        std::cerr << "--airports and --routes must be given together" << std::endl;
+        return 1;
+    }
+    // With a dataset, the snapshot is a cache that is rebuilt whenever it
+    // is older than either file.
+    long long snapshotTime = snapshotPath.empty() ? -1 : fileModifiedTime(snapshotPath);
+    bool snapshotCurrent = snapshotTime >= 0 && (airportsPath.empty() ||
+        (snapshotTime >= fileModifiedTime(airportsPath) && snapshotTime >= fileModifiedTime(routesPath)));
+    auto loadStart = std::chrono::steady_clock::now();
+    if (snapshotCurrent && loadGraphSnapshot(snapshotPath, graph)) 
+    {
+        log << "Loaded snapshot with " << graph.airportCount() << " airports and " << graph.edgeCount()
+            << " links in " << std::fixed << std::setprecision(2)
+            << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count()
+            << " ms" << std::endl;
+        log.unsetf(std::ios::floatfield);
+        log << std::setprecision(6);
+    }
+    else if (airportsPath.empty() && !snapshotPath.empty()) 
+    {
+        std::cerr << "Could not load snapshot " << snapshotPath << std::endl;
+        return 1;
+    }
+    else if (airportsPath.empty()) 
+    {
+        graph = makeDefaultNetwork();
+        if (nearestLinks > 0) 
+        {
+            FlightGraph linked;
+            linked.airports = graph.airports;
+            KdTree tree;
+            tree.build(linked.airports);
+            WorkStealingPool pool(1);
+            connectNearest(linked, tree, nearestLinks, pool);
+            graph = std::move(linked);
+        }
+    }
+    else 
+    {
+        CsvLoadStats loadStats;
+        if (!loadNetworkCsv(airportsPath, routesPath, graph, &loadStats)) 
+        {
+            std::cerr << "Could not read " << airportsPath << " or " << routesPath << std::endl;
+            return 1;
+        }
+        log << "Loaded " << loadStats.airports << " airports and " << loadStats.routes << " routes ("
+            << graph.edgeCount() << " links, " << loadStats.skipped << " rows skipped) in "
+            << std::fixed << std::setprecision(1) << loadStats.seconds * 1000 << " ms, "
+            << loadStats.megabytesPerSecond() << " MB/s" << std::endl;
+        log.unsetf(std::ios::floatfield);
+        log << std::setprecision(6);
+        if (!snapshotPath.empty() && !saveGraphSnapshot(graph, snapshotPath)) 
+        {
+            std::cerr << "Could not write snapshot " << snapshotPath << std::endl;
+        }
+    }
+    int n = graph.airportCount();
+
+    if (!batchPath.empty()) 
+    {
+        if (!weatherFeedPath.empty() && !applyWeatherFeed(graph, weatherFeedPath, nullptr, log)) return 1;
+
+        std::ifstream batchFile;
+        if (batchPath != "-") 
+        {
+            batchFile.open(batchPath);
+            if (!batchFile) 
+            {
+                std::cerr << "Could not open batch " << batchPath << std::endl;
+                return 1;
+            }
+        }
+        std::ofstream outputFile;
+        if (!outputPath.empty()) 
+        {
+            outputFile.open(outputPath, std::ios::binary | std::ios::trunc);
+            if (!outputFile) 
+            {
+                std::cerr << "Could not write " << outputPath << std::endl;
+                return 1;
+            }
+        }
+        std::istream& queries = batchPath == "-" ? std::cin : batchFile;
+        std::ostream& out = outputPath.empty() ? std::cout : outputFile;
+        if (batchMode.empty()) 
+        {
+            BatchStats batchStats;
+            bool written = runRouteBatch(graph, queries, out, batchOptions, &batchStats);
+            std::cerr << "Answered " << batchStats.queries << " queries (" << batchStats.invalid << " invalid, "
+                      << batchStats.found << " routed, " << batchStats.rerouted << " rerouted) in "
+                      << std::fixed << std::setprecision(1) << batchStats.seconds * 1000 << " ms, "
+                      << std::setprecision(0) << batchStats.queriesPerSecond() << " queries/s" << std::endl;
+            return written ? 0 : 1;
+        }
 
-    graph.addAirport("JFK", 150, 100);
-    graph.addAirport("LAX", 50, 500);
-    graph.addAirport("ORD", 350, 150);
-    graph.addAirport("DFW", 450, 350);
-    graph.addAirport("ATL", 300, 300);
-    graph.addAirport("SFO", 100, 450);
-    graph.addAirport("MIA", 250, 550);
-    graph.addAirport("SEA", 50, 50);
-    graph.addAirport("DEN", 300, 200);
-    graph.addAirport("BOS", 200, 80);
-    graph.addAirport("LAS", 150, 450);
-    graph.addAirport("PHX", 350, 450);
-    graph.addAirport("IAH", 500, 400);
-    graph.addAirport("EWR", 180, 90);
-    graph.addAirport("CLT", 330, 280);
+        std::vector<std::pair<int, int>> endpoints;
+        readBatchEndpoints(queries, graph, endpoints, std::cerr);
 
-    int n = graph.airports.size();
-    for (int i = 0; i < n; ++i) 
+        if (batchMode == "--forecast") 
+        {
+            std::ifstream forecastFile(forecastPath);
+            std::vector<ForecastSample> samples;
+            std::string error;
+            if (!forecastFile) 
+            {
+                std::cerr << "Could not open " << forecastPath << std::endl;
+                return 1;
+            }
+            if (!readForecast(forecastFile, graph, samples, error)) 
+            {
+                std::cerr << forecastPath << ", " << error << std::endl;
+                return 1;
+            }
+            TravelTimes times = buildTravelTimes(graph, samples);
+            ForecastBatchStats forecastStats;
+            bool written = runForecastBatch(graph, times, departHour, modeGiven ? batchOptions.mode : SearchMode::AStar,
+                                            endpoints, out, &forecastStats);
+            std::cerr << "Routed " << forecastStats.found << " of " << forecastStats.queries << " queries on "
+                      << samples.size() << " forecast samples (" << times.pool.size() << " breakpoints) in "
+                      << std::fixed << std::setprecision(1) << forecastStats.seconds * 1000 << " ms" << std::endl;
+            return written ? 0 : 1;
+        }
+
+        FailureModel failures(graph, failureRate);
+        if (!failuresPath.empty() && !readFailures(graph, failuresPath, failures)) return 1;
+
+        if (batchMode == "--pareto") 
+        {
+            std::vector<Criterion> kinds;
+            if (!parseCriteria(paretoList, kinds)) 
+            {
+                std::cerr << "Unknown --pareto criteria " << paretoList << std::endl;
+                return 1;
+            }
+            RouteCriteria criteria = makeRouteCriteria(graph, kinds, &failures.probability);
+            ParetoBatchStats paretoStats;
+            bool written = runParetoBatch(graph, criteria, pareto, endpoints, out, &paretoStats);
+            std::cerr << "Found " << paretoStats.routes << " Pareto routes for " << paretoStats.queries
+                      << " queries (" << paretoStats.labels << " labels, " << paretoStats.truncated
+                      << " truncated) in " << std::fixed << std::setprecision(1) << paretoStats.seconds * 1000
+                      << " ms" << std::endl;
+            return written ? 0 : 1;
+        }
+
+        ScenarioOptions scenarioOptions;
+        scenarioOptions.scenarios = scenarioCount;
+        scenarioOptions.seed = scenarioSeed;
+        scenarioOptions.threads = batchThreads;
+        if (modeGiven) scenarioOptions.mode = batchOptions.mode;
+        ScenarioStats scenarioStats;
+        bool written = runScenarioBatch(graph, failures, endpoints, out, scenarioOptions, &scenarioStats);
+        std::cerr << "Evaluated " << endpoints.size() << " routes over " << scenarioStats.scenarios << " scenarios ("
+                  << std::fixed << std::setprecision(1)
+                  << double(scenarioStats.failedEdges) / std::max(1, scenarioStats.scenarios)
+                  << " failed legs each, " << scenarioStats.searches << " reroute searches) on "
+                  << scenarioStats.threads << " threads in " << std::setprecision(3) << scenarioStats.seconds
+                  << " s, " << std::setprecision(0) << scenarioStats.scenariosPerSecond() << " scenarios/s"
+                  << std::endl;
+        return written ? 0 : 1;
+    }
+
+    if (!servePath.empty()) 
+    {
+        if (!weatherFeedPath.empty() && !applyWeatherFeed(graph, weatherFeedPath, nullptr, std::cout)) return 1;
+        RouteService service(graph, batchOptions.mode);
+        return service.run(servePath, std::cout) ? 0 : 1;
+    }
+
+    if (simulateSeconds > 0.0) 
     {
-        for (int j = i + 1; j < n; ++j) 
+        if (!weatherFeedPath.empty() && !applyWeatherFeed(graph, weatherFeedPath, nullptr, std::cout)) return 1;
+        FleetKinematics fleet;
+        int added = addRandomFlights(fleet, graph, fleetSize > 0 ? fleetSize : 1000, 40.0f, 120.0f, 2024);
+        simulation.duration = simulateSeconds;
+        if (!timeScaleGiven) simulation.timeScale = 0.0;
+
+        auto start = std::chrono::steady_clock::now();
+        auto nextReport = start + std::chrono::seconds(1);
+        FleetSimulation simulator(fleet, simulation);
+        simulator.start();
+        while (!simulator.done()) 
         {
-            const auto& pi = graph.airports[i].position;
-            const auto& pj = graph.airports[j].position;
-            double dx = pi.x - pj.x;
-            double dy = pi.y - pj.y;
-            double dist = std::sqrt(dx * dx + dy * dy);
-            graph.addEdge(i, j, dist);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            if (std::chrono::steady_clock::now() >= nextReport && simulator.acquire()) 
+            {
+                std::cout << "  t = " << simulator.snapshot().time << " s" << std::endl;
+                nextReport += std::chrono::seconds(1);
+            }
         }
+        simulator.stop();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double steps = static_cast<double>(simulator.steps());
+        std::cout << "Simulated " << added << " aircraft for " << steps * simulation.timestep << " s in "
+                  << std::fixed << std::setprecision(3) << seconds << " s: " << std::setprecision(0)
+                  << steps / seconds << " steps/s, " << steps * simulation.timestep / seconds << "x real time, "
+                  << steps * added / seconds << " aircraft updates/s" << std::endl;
+        return 0;
+    }
+
+    if (eventHours > 0.0) 
+    {
+        if (weatherInterval <= 0.0) 
+        {
+            std::cerr << "--weather-interval must be positive" << std::endl;
+            return 1;
+        }
+        FleetEventOptions events;
+        events.aircraft = fleetSize > 0 ? fleetSize : 1000;
+        events.hours = eventHours;
+        events.weatherInterval = weatherInterval;
+        if (modeGiven && !batchOptions.useHierarchy) events.mode = batchOptions.mode;
+
+        std::ifstream feedFile;
+        std::unique_ptr<WeatherFeedReader> feed;
+        WeatherSource weather = randomWeather(std::max(1, graph.edgeCount() / 50), 0.5, 2024);
+        if (!weatherFeedPath.empty()) 
+        {
+            if (weatherFeedPath != "-") 
+            {
+                feedFile.open(weatherFeedPath, std::ios::binary);
+                if (!feedFile) 
+                {
+                    std::cerr << "Could not open weather feed " << weatherFeedPath << std::endl;
+                    return 1;
+                }
+            }
+            feed.reset(new WeatherFeedReader(weatherFeedPath == "-" ? std::cin : feedFile, graph));
+            weather = [&feed](FlightGraph&, std::vector<int>& changed) {
+                WeatherEpochStats epochStats;
+                return feed->nextEpoch(epochStats, changed);
+            };
+        }
+
+        FleetEventSimulation simulator(graph, events, weather);
+        FleetEventStats stats;
+        simulator.run(stats);
+        std::cout << "Simulated " << events.aircraft << " aircraft for " << std::fixed << std::setprecision(1)
+                  << stats.simulatedHours << " h in " << std::setprecision(3) << stats.seconds << " s ("
+                  << std::setprecision(0) << stats.simulatedHours * 3600 / stats.seconds << "x real time)" << std::endl;
+        std::cout << stats.events << " events: " << stats.departures << " departures, " << stats.legs << " legs, "
+                  << stats.landings << " landings, " << stats.weatherEpochs << " weather epochs" << std::endl;
+        std::cout << stats.edgesClosed << " edges closed, " << stats.reroutes << " reroutes in flight, "
+                  << stats.grounded << " holds on the ground, " << stats.searches << " route searches" << std::endl;
+        std::cout << stats.eventsPerSecond() << " events/s" << std::endl;
+        return 0;
+    }
+
+    ContractionHierarchy hierarchy;
+    if (useHierarchy) 
+    {
+        hierarchy.build(graph);
     }
 
     printLine('=');
@@ -661,14 +1096,24 @@ int main(int argc, char* argv[]) {
     
     std::cout << "Selected route: " << graph.airports[src].code << " to "   << graph.airports[dst].code << std::endl;
 
+    RouteTracker tracker(graph);
+    tracker.trackSource(src);
+
     printLine('=');
     std::cout << "WEATHER CONDITIONS UPDATE" << std::endl;
     printLine('=');
     
-    std::cout << "Would you like to update weather conditions? (y/n): ";
-    std::cout.flush();
     std::string updateWeather;
-    std::cin >> updateWeather;
+    if (!weatherFeedPath.empty()) 
+    {
+        if (!applyWeatherFeed(graph, weatherFeedPath, &tracker, std::cout)) return 1;
+    }
+    else 
+    {
+        std::cout << "Would you like to update weather conditions? (y/n): ";
+        std::cout.flush();
+        std::cin >> updateWeather;
+    }
 
     if (updateWeather == "y" || updateWeather == "Y") 
     {
@@ -709,7 +1154,19 @@ int main(int argc, char* argv[]) {
                 description = "Clear skies";
             }
             
-            graph.updateWeather(a1, a2, condition == 1, description);
+            if (a1 < 0 || a1 >= n || a2 < 0 || a2 >= n) 
+            {
+                std::cout << "Invalid airport, update skipped." << std::endl;
+                continue;
+            }
+            int e = graph.updateWeather(a1, a2, condition == 1, description);
+            if (e < 0) 
+            {
+                std::cout << "No leg between " << graph.airports[a1].code << " and " << graph.airports[a2].code
+                          << ", update skipped." << std::endl;
+                continue;
+            }
+            tracker.edgeChanged(e);
             
             std::cout << "Weather updated: " 
             << graph.airports[a1].code << " to " 
@@ -719,37 +1176,30 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    FlightGraph directGraph = graph;
+    auto route = [&](const GraphView& view, SearchStats* stats) {
+        if (!useHierarchy) return view.shortestPath(src, dst, searchMode, stats);
+        hierarchy.customize(view);
+        return hierarchy.query(src, dst, stats);
+    };
+
+    GraphView directView(graph);
+    directView.ignoreWeather = true;
     
-    for (int i = 0; i < directGraph.airports.size(); ++i) 
-    {
-        for (int j = 0; j < directGraph.airports.size(); ++j) 
-        {
-            if (i != j) 
-            {
-                directGraph.pathAvailable[i][j] = true;
-            }
-        }
-    }
+    SearchStats directStats;
+    std::vector<int> directPath = route(directView, &directStats);
     
-    std::vector<int> directPath = directGraph.dijkstra(src, dst);
+    GraphView weatherView(graph);
     
-    FlightGraph weatherGraph = graph;
 
-    for (int i = 0; i < weatherGraph.airports.size(); ++i) 
+    SearchStats weatherStats;
+    std::vector<int> weatherAwarePath = argc == 4 ? route(weatherView, &weatherStats) : tracker.path(src, dst);
+    
+    if (argc == 4) 
     {
-        for (int j = 0; j < weatherGraph.airports.size(); ++j) 
-        {
-            if (weatherGraph.pathWeather[i][j].isBad) 
-            {
-                weatherGraph.pathAvailable[i][j] = false;
-            }
-        }
+        std::cout << "Search mode " << argv[3] << ": settled " << directStats.settled 
+                  << " airports (direct), " << weatherStats.settled << " (weather-aware)" << std::endl;
     }
     
-
-    std::vector<int> weatherAwarePath = weatherGraph.dijkstra(src, dst);
-    
     bool hasDirectPathBadWeather = false;
     std::vector<std::pair<std::string, std::string>> badWeatherSegments;
     
@@ -790,7 +1240,7 @@ int main(int argc, char* argv[]) {
             {
                 int u = finalPath[i-1];
                 int v = finalPath[i];
-                if (graph.pathWeather[u][v].isBad) 
+                if (graph.isEdgeBad(u, v)) 
                 {
                     finalPathHasBadWeather = true;
                     std::cout << "WARNING: Rerouted path still contains bad weather segment: " 
@@ -800,17 +1250,14 @@ int main(int argc, char* argv[]) {
             
             if (finalPathHasBadWeather) {
                 std::cout << "Fixing rerouted path to completely avoid bad weather...\n";
-                FlightGraph fixedGraph = graph;
-                for (int i = 0; i < fixedGraph.airports.size(); ++i) 
+                GraphView fixedView(graph);
+                for (size_t i = 1; i < finalPath.size(); ++i) 
                 {
-                    for (int j = 0; j < fixedGraph.airports.size(); ++j) 
-                    {
-                        if (fixedGraph.pathWeather[i][j].isBad) {
-                            fixedGraph.pathAvailable[i][j] = false;
-                        }
+                    if (graph.isEdgeBad(finalPath[i-1], finalPath[i])) {
+                        fixedView.closeEdge(finalPath[i-1], finalPath[i]);
                     }
                 }
-                finalPath = fixedGraph.dijkstra(src, dst);
+                finalPath = route(fixedView, nullptr);
                 if (finalPath.empty()) {
                     std::cout << "No completely safe path found. Using best available route.\n";
                     finalPath = weatherAwarePath;
@@ -826,17 +1273,15 @@ int main(int argc, char* argv[]) {
         {
             std::cout << "Attempting to find alternative route...\n";
 
-            FlightGraph rerouteGraph = graph;
+            GraphView rerouteView(graph);
 
-            for (int i = 0; i < rerouteGraph.airports.size(); ++i) {
-                for (int j = 0; j < rerouteGraph.airports.size(); ++j) {
-                    if (rerouteGraph.pathWeather[i][j].isBad) {
-                        rerouteGraph.pathAvailable[i][j] = false;
-                    }
+            for (size_t i = 1; i < directPath.size(); ++i) {
+                if (graph.isEdgeBad(directPath[i-1], directPath[i])) {
+                    rerouteView.closeEdge(directPath[i-1], directPath[i]);
                 }
             }
 
-            std::vector<int> alternativePath = rerouteGraph.dijkstra(src, dst);
+            std::vector<int> alternativePath = route(rerouteView, nullptr);
             
             if (alternativePath.empty()) {
                 std::cout << "No alternative route found. All possible paths are affected by bad weather.\n";
@@ -864,6 +1309,10 @@ int main(int argc, char* argv[]) {
         std::cout << "\n";
     }
 
-    visualizeGraph(graph, finalPath, rerouted);
+#ifndef AERO_HEADLESS
+    visualizeGraph(graph, finalPath, rerouted, fleetSize, simulation);
+#else
+    (void)rerouted;
+#endif
     return 0;
 }
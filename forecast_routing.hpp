@@ -0,0 +1,333 @@
+#pragma once
+
+#include "route_batch.hpp"
+
+// Time-dependent routing on forecast weather. Instead of being open or
+// closed now, every leg has a travel time that depends on when it is
+// flown: a piecewise-linear function of the departure time (hours from
+// the start of the forecast, so never negative) built from the forecast
+// samples of the leg.
+//
+// All legs' functions live in one shared breakpoint pool; leg e owns
+// pool[first[e] .. first[e + 1]), at least one breakpoint, so looking up
+// a travel time is the same branch-free binary search and one multiply-add
+// for every leg, with or without a forecast.
+//
+// Functions are FIFO: leaving later never arrives earlier, since an
+// aircraft can always wait at the airport instead. That makes the
+// time-dependent Dijkstra below (earliest arrival per airport, relaxing a
+// leg at the arrival time at its start) exact, as is A* with a potential
+// that bounds every travel time from below.
+
+// One forecast sample: from hour on, flying the leg takes factor times as
+// long as in clear weather, or it is closed if factor is 0.
+struct ForecastSample
+{
+    int edge;
+    float hour;
+    float factor;
+};
+
+struct TravelTimes
+{
+    // The function on [time, next breakpoint's time) is value + slope *
+    // (t - time); the last breakpoint's holds from then on with slope 0,
+    // and the first's value holds before it. Two breakpoints at the same
+    // time make a jump.
+    struct Breakpoint
+    {
+        float time;
+        float value;
+        float slope;
+    };
+
+    std::vector<int> first;             // per edge, plus one
+    std::vector<Breakpoint> pool;
+    double lowerBoundPerDistance = 0.0; // no travel time is below this times the leg's length
+
+    int edgeCount() const { return static_cast<int>(first.size()) - 1; }
+    size_t bytes() const { return first.size() * sizeof(int) + pool.size() * sizeof(Breakpoint); }
+
+    // Hours to fly edge e leaving at time t (infinite if it never reopens).
+    float at(int e, float t) const
+    {
+        const Breakpoint* b = pool.data() + first[e];
+        int n = first[e + 1] - first[e];
+        while (n > 1)
+        {
+            int half = n / 2;
+            b += b[half].time <= t ? half : 0;
+            n -= half;
+        }
+        return b->value + b->slope * std::max(0.0f, t - b->time);
+    }
+};
+
+// Travel times over graph's edges at speed (map units per hour), from
+// samples in any order. A leg without samples always takes its length
+// over speed. Between two samples of a leg its factor changes linearly;
+// before the first and after the last it holds. A closed leg can be
+// flown from the next sample that opens it on, so leaving while it is
+// closed takes the wait plus the flight; a leg whose first sample closes
+// it is closed from hour 0, and one that never reopens cannot be flown.
+inline TravelTimes buildTravelTimes(const FlightGraph& graph, std::vector<ForecastSample> samples, double speed = 250.0)
+{
+    using Breakpoint = TravelTimes::Breakpoint;
+    const float kClosed = std::numeric_limits<float>::infinity();
+    std::stable_sort(samples.begin(), samples.end(), [](const ForecastSample& a, const ForecastSample& b) {
+        return a.edge != b.edge ? a.edge < b.edge : a.hour < b.hour;
+    });
+
+    TravelTimes times;
+    int m = graph.edgeCount();
+    times.first.reserve(m + 1);
+    times.pool.reserve(m + 2 * samples.size());
+    times.lowerBoundPerDistance = std::numeric_limits<double>::infinity();
+    std::vector<Breakpoint> points, closure;
+    size_t next = 0;
+    for (int e = 0; e < m; ++e)
+    {
+        times.first.push_back(static_cast<int>(times.pool.size()));
+        float base = static_cast<float>(graph.edgeWeight[e] / speed);
+        size_t begin = next;
+        while (next < samples.size() && samples[next].edge == e) ++next;
+        if (begin == next)
+        {
+            times.pool.push_back({0.0f, base, 0.0f});
+            if (graph.edgeWeight[e] > 0.0)
+                times.lowerBoundPerDistance = std::min(times.lowerBoundPerDistance, base / graph.edgeWeight[e]);
+            continue;
+        }
+
+        // The function's corners, left to right. Of several at one time
+        // only the first (the limit from the left) and the last (the
+        // value from then on) count.
+        points.clear();
+        auto corner = [&points](float time, float value) {
+            size_t n = points.size();
+            if (n >= 2 && points[n - 1].time == time && points[n - 2].time == time) points.back().value = value;
+            else points.push_back({time, value, 0.0f});
+        };
+        for (size_t s = begin; s < next; ++s)
+        {
+            const ForecastSample& sample = samples[s];
+            if (sample.factor > 0.0f)
+            {
+                corner(sample.hour, base * sample.factor);
+                continue;
+            }
+            float hour = s == begin ? std::min(0.0f, sample.hour) : sample.hour;
+            if (s > begin && samples[s - 1].factor > 0.0f) corner(hour, points.back().value);
+            size_t open = s + 1;
+            while (open < next && samples[open].factor <= 0.0f) ++open;
+            if (open == next)
+            {
+                corner(hour, kClosed);
+                break;
+            }
+            corner(hour, samples[open].hour - hour + base * samples[open].factor);
+            s = open - 1;
+        }
+        if (points.front().time > 0.0f) points.insert(points.begin(), {0.0f, points.front().value, 0.0f});
+
+        // Waiting: right to left, a corner is lowered to leaving at the
+        // next one if that is sooner, and where a segment ends at a lowered
+        // corner, waiting for it wins from the crossing on.
+        closure.clear();
+        closure.push_back(points.back());
+        for (int i = static_cast<int>(points.size()) - 2; i >= 0; --i)
+        {
+            Breakpoint p = points[i];
+            const Breakpoint later = closure.back();
+            float gap = later.time - p.time;
+            float original = points[i + 1].value;
+            if (p.value >= later.value + gap)
+            {
+                p.value = later.value + gap;
+            }
+            else if (gap > 0.0f && original > later.value && std::isfinite(original))
+            {
+                float slope = (original - p.value) / gap;
+                float cross = p.time + (later.value + gap - p.value) / (slope + 1.0f);
+                closure.push_back({cross, later.value + (later.time - cross), 0.0f});
+            }
+            closure.push_back(p);
+        }
+
+        for (auto it = closure.rbegin(); it != closure.rend(); ++it)
+        {
+            Breakpoint b = *it;
+            auto after = it + 1;
+            if (after != closure.rend() && after->time > b.time && std::isfinite(b.value) && std::isfinite(after->value))
+                b.slope = (after->value - b.value) / (after->time - b.time);
+            times.pool.push_back(b);
+            if (graph.edgeWeight[e] > 0.0)
+                times.lowerBoundPerDistance = std::min(times.lowerBoundPerDistance, b.value / graph.edgeWeight[e]);
+        }
+    }
+    times.first.push_back(static_cast<int>(times.pool.size()));
+    if (!std::isfinite(times.lowerBoundPerDistance)) times.lowerBoundPerDistance = 0.0;
+    return times;
+}
+
+// Reads a forecast, one sample per line,
+//
+//   <hour> <airport> <airport> <factor>    airports by index or code
+//   <hour> <airport> <airport> closed
+//   # comment
+//
+// and appends it to samples. Returns false, with the line number in
+// error, on a malformed line or an unknown airport or leg.
+inline bool readForecast(std::istream& in, const FlightGraph& graph, std::vector<ForecastSample>& samples,
+                         std::string& error)
+{
+    AirportLookup airports(graph);
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number)
+    {
+        std::string_view rest(line);
+        std::string_view first = nextToken(rest);
+        if (first.empty() || first[0] == '#') continue;
+        double hour, factor = 0.0;
+        bool parsed = parseCsvDouble(first, hour);
+        int u = airports.find(nextToken(rest)), v = airports.find(nextToken(rest));
+        std::string_view condition = nextToken(rest);
+        if (condition != "closed") parsed = parsed && parseCsvDouble(condition, factor) && factor > 0.0;
+        if (!parsed || u < 0 || v < 0 || hour < 0.0)
+        {
+            error = "line " + std::to_string(number) + ": expected <hour> <airport> <airport> <factor>|closed";
+            return false;
+        }
+        int e = graph.findEdge(u, v);
+        if (e < 0)
+        {
+            error = "line " + std::to_string(number) + ": no leg between those airports";
+            return false;
+        }
+        samples.push_back({e, static_cast<float>(hour), static_cast<float>(factor)});
+    }
+    return true;
+}
+
+// The fastest route from src to dst leaving at departure (hours), into
+// path (left empty when there is none), on the view's weather and times'
+// travel times. stats->distance is the travel time in hours. A* (either
+// A* mode; there is no bidirectional search, as the arrival time is not
+// known up front) uses the straight-line distance over the fastest
+// possible speed as its potential.
+inline void fastestRoute(const GraphView& view, const TravelTimes& times, int src, int dst, double departure,
+                         std::vector<int>& path, SearchMode mode, SearchStats* stats = nullptr,
+                         SearchWorkspace& ws = SearchWorkspace::local())
+{
+    SearchStats local;
+    SearchStats& st = stats ? *stats : local;
+    st = SearchStats();
+    path.clear();
+
+    const FlightGraph& g = *view.graph;
+    bool useHeuristic = mode == SearchMode::AStar || mode == SearchMode::BidirectionalAStar;
+    double scale = useHeuristic ? g.heuristicScale * times.lowerBoundPerDistance : 0.0;
+    SearchLabels& labels = ws.labels[0];
+    LazyHeap& queue = ws.queue<LazyHeap>(0);
+    ws.begin<LazyHeap>(g.airportCount());
+    labels.set(src, departure, -1);
+    queue.push(departure + scale * g.straightLineDistance(src, dst), src);
+
+    while (!queue.empty())
+    {
+        int u = queue.pop().second;
+        if (labels.isSettled(u)) continue;
+        labels.settle(u);
+        ++st.settled;
+        if (u == dst) break;
+
+        double arrival = labels.dist[u];
+        float now = static_cast<float>(arrival);
+        for (int a = g.arcOffset[u]; a < g.arcOffset[u + 1]; ++a)
+        {
+            int e = g.arcEdge[a];
+            if (!view.isAvailable(e)) continue;
+
+            int v = g.arcTarget[a];
+            double alt = arrival + times.at(e, now);
+            if (alt < labels.distance(v))
+            {
+                labels.set(v, alt, u);
+                queue.push(alt + scale * g.straightLineDistance(v, dst), v);
+            }
+        }
+    }
+
+    double arrival = labels.distance(dst);
+    if (arrival == std::numeric_limits<double>::infinity()) return;
+    st.distance = arrival - departure;
+    for (int at = dst; at != -1; at = labels.prev[at])
+        path.push_back(at);
+    std::reverse(path.begin(), path.end());
+}
+
+// Appends the JSON line (with its '\n') for a fastest route: departure,
+// arrival and travel time in hours and the path, or found false.
+//
+//   {"src":"JFK","dst":"MIA","found":true,"departure":6.000,"arrival":8.137,
+//    "hours":2.137,"path":["JFK","ATL","MIA"]}
+inline void appendFastestRouteJson(std::string& out, const FlightGraph& graph, int src, int dst, double departure,
+                                   const std::vector<int>& path, double hours)
+{
+    char number[64];
+    out += "{\"src\":";
+    appendJsonString(out, graph.airports[src].code);
+    out += ",\"dst\":";
+    appendJsonString(out, graph.airports[dst].code);
+    out += path.empty() ? ",\"found\":false" : ",\"found\":true";
+    std::snprintf(number, sizeof number, ",\"departure\":%.3f", departure);
+    out += number;
+    if (!path.empty())
+    {
+        std::snprintf(number, sizeof number, ",\"arrival\":%.3f,\"hours\":%.3f", departure + hours, hours);
+        out += number;
+    }
+    out += ",\"path\":[";
+    for (size_t k = 0; k < path.size(); ++k)
+    {
+        if (k) out += ',';
+        appendJsonString(out, graph.airports[path[k]].code);
+    }
+    out += "]}\n";
+}
+
+struct ForecastBatchStats
+{
+    long long queries = 0;
+    long long found = 0;
+    double seconds = 0.0;
+};
+
+// Batch mode for forecasts: the fastest route for every query between
+// endpoints, leaving at departure, written as one appendFastestRouteJson
+// line each to out, in order. Returns false if out fails.
+inline bool runForecastBatch(const FlightGraph& graph, const TravelTimes& times, double departure, SearchMode mode,
+                             const std::vector<std::pair<int, int>>& endpoints, std::ostream& out,
+                             ForecastBatchStats* stats = nullptr)
+{
+    ForecastBatchStats local;
+    ForecastBatchStats& st = stats ? *stats : local;
+    st = ForecastBatchStats();
+    auto start = std::chrono::steady_clock::now();
+
+    GraphView view(graph);
+    std::vector<int> path;
+    SearchStats searchStats;
+    std::string buffer;
+    for (const auto& query : endpoints)
+    {
+        fastestRoute(view, times, query.first, query.second, departure, path, mode, &searchStats);
+        appendFastestRouteJson(buffer, graph, query.first, query.second, departure, path, searchStats.distance);
+        ++st.queries;
+        st.found += !path.empty();
+    }
+    st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    out.write(buffer.data(), buffer.size());
+    out.flush();
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,241 @@
+#pragma once
+
+#include "flight_graph.hpp"
+#include "mapped_file.hpp"
+#include <fstream>
+#include <cstring>
+
+// Binary snapshot of a finalized FlightGraph, little-endian, version 2:
+//
+//   SnapshotHeader, then one section per SnapshotSection id, each starting
+//   on a 64-byte boundary. Integer arrays are 32-bit, weights are IEEE
+//   doubles, positions are float x/y pairs, weather is the packed 64-bit
+//   hazard layers plus their combined mask and string tables are an offset
+//   array (count + 1 entries) followed by the concatenated characters.
+//
+// loadGraphSnapshot() maps the file copy-on-write and points the graph's
+// edge and CSR arrays straight at the mapped sections, so nothing is
+// parsed or copied for them; weather updates dirty only the pages they
+// touch. Only the airport table and the weather descriptions are rebuilt.
+const char kSnapshotMagic[8] = {'A', 'E', 'R', 'O', 'G', 'R', 'P', 'H'};
+const std::uint32_t kSnapshotVersion = 2;
+const std::uint64_t kSnapshotAlignment = 64;
+
+enum SnapshotSection
+{
+    SectionAirportPositions,
+    SectionAirportCodeOffsets,
+    SectionAirportCodes,
+    SectionEdgeFrom,
+    SectionEdgeTo,
+    SectionEdgeWeight,
+    SectionHazardBits,
+    SectionAvailableBits,
+    SectionEdgeDescription,
+    SectionArcOffset,
+    SectionArcTarget,
+    SectionArcEdge,
+    SectionArcWeight,
+    SectionDescriptionOffsets,
+    SectionDescriptions,
+    SectionCount
+};
+
+struct SnapshotHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint32_t airportCount;
+    std::uint32_t edgeCount;
+    std::uint32_t descriptionCount;
+    std::uint32_t reserved;
+    double heuristicScale;
+    std::uint64_t sectionOffset[SectionCount];
+    std::uint64_t sectionBytes[SectionCount];
+};
+
+inline bool isLittleEndianHost()
+{
+    std::uint32_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+inline bool saveGraphSnapshot(const FlightGraph& graph, const std::string& path)
+{
+    if (!isLittleEndianHost()) return false;
+
+    int n = graph.airportCount();
+    int m = graph.edgeCount();
+
+    std::vector<float> positions(2 * static_cast<size_t>(n));
+    std::vector<std::uint32_t> codeOffsets(n + 1, 0);
+    std::string codes;
+    for (int i = 0; i < n; ++i)
+    {
+        positions[2 * i] = graph.airports[i].position.x;
+        positions[2 * i + 1] = graph.airports[i].position.y;
+        codes += graph.airports[i].code;
+        codeOffsets[i + 1] = static_cast<std::uint32_t>(codes.size());
+    }
+
+    std::vector<std::uint32_t> descriptionOffsets(graph.weatherDescriptions.size() + 1, 0);
+    std::string descriptions;
+    for (size_t i = 0; i < graph.weatherDescriptions.size(); ++i)
+    {
+        descriptions += graph.weatherDescriptions[i];
+        descriptionOffsets[i + 1] = static_cast<std::uint32_t>(descriptions.size());
+    }
+
+    std::uint64_t words = graph.weatherWords();
+    const void* source[SectionCount] = {
+        positions.data(), codeOffsets.data(), codes.data(),
+        graph.edgeFrom.data(), graph.edgeTo.data(), graph.edgeWeight.data(),
+        graph.hazardBits.data(), graph.availableBits.data(), graph.edgeDescription.data(),
+        graph.arcOffset.data(), graph.arcTarget.data(), graph.arcEdge.data(), graph.arcWeight.data(),
+        descriptionOffsets.data(), descriptions.data()};
+    std::uint64_t bytes[SectionCount] = {
+        positions.size() * sizeof(float), codeOffsets.size() * 4, codes.size(),
+        m * 4ull, m * 4ull, m * 8ull,
+        kHazardCount * words * 8, words * 8, m * 4ull,
+        (n + 1) * 4ull, 2 * m * 4ull, 2 * m * 4ull, 2 * m * 8ull,
+        descriptionOffsets.size() * 4, descriptions.size()};
+
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof header.magic);
+    header.version = kSnapshotVersion;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.airportCount = n;
+    header.edgeCount = m;
+    header.descriptionCount = static_cast<std::uint32_t>(graph.weatherDescriptions.size());
+    header.heuristicScale = graph.heuristicScale;
+
+    auto align = [](std::uint64_t at) { return (at + kSnapshotAlignment - 1) / kSnapshotAlignment * kSnapshotAlignment; };
+    std::uint64_t at = align(sizeof(SnapshotHeader));
+    for (int s = 0; s < SectionCount; ++s)
+    {
+        header.sectionOffset[s] = at;
+        header.sectionBytes[s] = bytes[s];
+        at = align(at + bytes[s]);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    const char padding[kSnapshotAlignment] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof header);
+    std::uint64_t written = sizeof header;
+    for (int s = 0; s < SectionCount; ++s)
+    {
+        out.write(padding, header.sectionOffset[s] - written);
+        out.write(static_cast<const char*>(source[s]), bytes[s]);
+        written = header.sectionOffset[s] + bytes[s];
+    }
+    out.write(padding, at - written);
+    return static_cast<bool>(out);
+}
+
+// One pass over the borrowed arrays: every airport, edge and description
+// index in range and the arc offsets monotone, so a damaged file of the
+// right size cannot send a search out of bounds.
+inline bool validSnapshotTopology(const FlightGraph& g, std::uint64_t n, std::uint64_t m, std::uint64_t k)
+{
+    if (n >= static_cast<std::uint64_t>(std::numeric_limits<int>::max()) ||
+        2 * m >= static_cast<std::uint64_t>(std::numeric_limits<int>::max()))
+        return false;
+    int airports = static_cast<int>(n), edges = static_cast<int>(m);
+    for (int e = 0; e < edges; ++e)
+    {
+        if (g.edgeFrom[e] < 0 || g.edgeFrom[e] >= airports || g.edgeTo[e] < 0 || g.edgeTo[e] >= airports ||
+            g.edgeDescription[e] >= k)
+            return false;
+    }
+    if (g.arcOffset[0] != 0 || g.arcOffset[airports] != 2 * edges) return false;
+    for (int u = 0; u < airports; ++u)
+        if (g.arcOffset[u] > g.arcOffset[u + 1]) return false;
+    for (int a = 0; a < 2 * edges; ++a)
+    {
+        if (g.arcTarget[a] < 0 || g.arcTarget[a] >= airports || g.arcEdge[a] < 0 || g.arcEdge[a] >= edges)
+            return false;
+    }
+    return true;
+}
+
+// Replaces graph with the snapshot at path. Returns false, leaving graph
+// untouched, if the file is missing, truncated, of another version or
+// damaged.
+inline bool loadGraphSnapshot(const std::string& path, FlightGraph& graph)
+{
+    if (!isLittleEndianHost()) return false;
+
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(path, true) || file->size < sizeof(SnapshotHeader)) return false;
+
+    SnapshotHeader header;
+    std::memcpy(&header, file->data, sizeof header);
+    if (std::memcmp(header.magic, kSnapshotMagic, sizeof header.magic) != 0 ||
+        header.version != kSnapshotVersion || header.headerSize != sizeof(SnapshotHeader))
+        return false;
+
+    std::uint64_t n = header.airportCount, m = header.edgeCount, k = header.descriptionCount;
+    std::uint64_t words = edgeWords(header.edgeCount);
+    std::uint64_t expected[SectionCount] = {
+        2 * n * sizeof(float), (n + 1) * 4, header.sectionBytes[SectionAirportCodes],
+        m * 4, m * 4, m * 8, kHazardCount * words * 8, words * 8, m * 4,
+        (n + 1) * 4, 2 * m * 4, 2 * m * 4, 2 * m * 8,
+        (k + 1) * 4, header.sectionBytes[SectionDescriptions]};
+    for (int s = 0; s < SectionCount; ++s)
+    {
+        if (header.sectionBytes[s] != expected[s] || header.sectionOffset[s] % kSnapshotAlignment != 0 ||
+            header.sectionOffset[s] > file->size || header.sectionBytes[s] > file->size - header.sectionOffset[s])
+            return false;
+    }
+
+    char* base = file->data;
+    auto section = [&](SnapshotSection s) { return base + header.sectionOffset[s]; };
+    const float* positions = reinterpret_cast<const float*>(section(SectionAirportPositions));
+    const std::uint32_t* codeOffsets = reinterpret_cast<const std::uint32_t*>(section(SectionAirportCodeOffsets));
+    const char* codes = section(SectionAirportCodes);
+    const std::uint32_t* descriptionOffsets = reinterpret_cast<const std::uint32_t*>(section(SectionDescriptionOffsets));
+    const char* descriptions = section(SectionDescriptions);
+    if (codeOffsets[n] != header.sectionBytes[SectionAirportCodes] ||
+        descriptionOffsets[k] != header.sectionBytes[SectionDescriptions] || k == 0)
+        return false;
+
+    FlightGraph loaded;
+    loaded.airports.resize(n);
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        if (codeOffsets[i] > codeOffsets[i + 1] || codeOffsets[i + 1] > codeOffsets[n]) return false;
+        loaded.airports[i].code.assign(codes + codeOffsets[i], codes + codeOffsets[i + 1]);
+        loaded.airports[i].position = {positions[2 * i], positions[2 * i + 1]};
+    }
+    loaded.weatherDescriptions.resize(k);
+    loaded.descriptionHazard.resize(k);
+    loaded.descriptionIndex.clear();
+    for (std::uint64_t i = 0; i < k; ++i)
+    {
+        if (descriptionOffsets[i] > descriptionOffsets[i + 1] || descriptionOffsets[i + 1] > descriptionOffsets[k]) return false;
+        loaded.weatherDescriptions[i].assign(descriptions + descriptionOffsets[i], descriptions + descriptionOffsets[i + 1]);
+        loaded.descriptionHazard[i] = i == 0 ? Hazard::Other : classifyHazard(loaded.weatherDescriptions[i]);
+        loaded.descriptionIndex.emplace(loaded.weatherDescriptions[i], static_cast<std::uint32_t>(i));
+    }
+
+    loaded.edgeFrom.borrow(reinterpret_cast<int*>(section(SectionEdgeFrom)), m);
+    loaded.edgeTo.borrow(reinterpret_cast<int*>(section(SectionEdgeTo)), m);
+    loaded.edgeWeight.borrow(reinterpret_cast<double*>(section(SectionEdgeWeight)), m);
+    loaded.hazardBits.borrow(reinterpret_cast<std::uint64_t*>(section(SectionHazardBits)), kHazardCount * words);
+    loaded.availableBits.borrow(reinterpret_cast<std::uint64_t*>(section(SectionAvailableBits)), words);
+    loaded.edgeDescription.borrow(reinterpret_cast<std::uint32_t*>(section(SectionEdgeDescription)), m);
+    loaded.arcOffset.borrow(reinterpret_cast<int*>(section(SectionArcOffset)), n + 1);
+    loaded.arcTarget.borrow(reinterpret_cast<int*>(section(SectionArcTarget)), 2 * m);
+    loaded.arcEdge.borrow(reinterpret_cast<int*>(section(SectionArcEdge)), 2 * m);
+    loaded.arcWeight.borrow(reinterpret_cast<double*>(section(SectionArcWeight)), 2 * m);
+    if (!validSnapshotTopology(loaded, n, m, k)) return false;
+
+    loaded.heuristicScale = header.heuristicScale;
+    loaded.storage = file;
+    graph = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <afunix.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// Where the routing service (route_service.hpp) listens by default.
+const char kRouteServiceSocket[] = "aero_route.sock";
+
+// Stream socket on a local (Unix-domain) path, with line-based reads.
+// Windows 10 and later support AF_UNIX through Winsock; link with ws2_32.
+struct LocalSocket
+{
+#ifdef _WIN32
+    using Handle = SOCKET;
+    static constexpr Handle kInvalid = INVALID_SOCKET;
+#else
+    using Handle = int;
+    static constexpr Handle kInvalid = -1;
+#endif
+
+    LocalSocket() = default;
+    explicit LocalSocket(Handle h) : handle(h) {}
+    ~LocalSocket() { close(); }
+
+    LocalSocket(const LocalSocket&) = delete;
+    LocalSocket& operator=(const LocalSocket&) = delete;
+    LocalSocket(LocalSocket&& other) noexcept { *this = std::move(other); }
+
+    LocalSocket& operator=(LocalSocket&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            handle = other.handle;
+            buffer = std::move(other.buffer);
+            boundPath = std::move(other.boundPath);
+            boundFile = other.boundFile;
+            other.boundPath.clear();
+            other.handle = kInvalid;
+        }
+        return *this;
+    }
+
+    bool isOpen() const { return handle != kInvalid; }
+
+    bool connect(const std::string& path)
+    {
+        sockaddr_un address;
+        if (!open(path, address)) return false;
+        if (::connect(handle, reinterpret_cast<sockaddr*>(&address), sizeof address) != 0) return close(), false;
+        return true;
+    }
+
+    // Binds path. A socket file left by an earlier run is replaced, but
+    // only when nothing answers on it (the connection is refused) or it is
+    // already gone; if another server is listening there, listen fails
+    // with error saying so rather than taking the path over.
+    bool listen(const std::string& path, std::string& error, int backlog = 16)
+    {
+        sockaddr_un address;
+        LocalSocket probe;
+        if (!probe.open(path, address) || !open(path, address))
+        {
+            error = "cannot create a socket for that path";
+            return false;
+        }
+        if (::connect(probe.handle, reinterpret_cast<sockaddr*>(&address), sizeof address) == 0)
+        {
+            error = "a server is already running there";
+            return close(), false;
+        }
+#ifdef _WIN32
+        int failure = WSAGetLastError();
+        bool stale = failure == WSAECONNREFUSED || failure == ERROR_FILE_NOT_FOUND || failure == ERROR_PATH_NOT_FOUND;
+        if (stale) DeleteFileA(path.c_str());
+#else
+        int failure = errno;
+        struct stat file;
+        bool stale = failure == ENOENT ||
+                     (failure == ECONNREFUSED && (::lstat(path.c_str(), &file) != 0 || S_ISSOCK(file.st_mode)));
+        if (stale) ::unlink(path.c_str());
+#endif
+        if (!stale)
+        {
+            error = "the path is in use and not a stale socket";
+            return close(), false;
+        }
+        if (::bind(handle, reinterpret_cast<sockaddr*>(&address), sizeof address) != 0 ||
+            ::listen(handle, backlog) != 0)
+        {
+            error = "cannot bind the path";
+            return close(), false;
+        }
+        boundPath = path;
+        boundFile = fileIdentity(path);
+        return true;
+    }
+
+    // Whether the path listen() bound still names this socket's file,
+    // i.e. it has not since been removed or replaced by someone else's.
+    bool ownsBoundPath() const { return !boundPath.empty() && fileIdentity(boundPath) == boundFile; }
+
+    // Deletes the socket file listen() created, if it still owns it.
+    void removeBoundPath()
+    {
+        if (ownsBoundPath())
+        {
+#ifdef _WIN32
+            DeleteFileA(boundPath.c_str());
+#else
+            ::unlink(boundPath.c_str());
+#endif
+        }
+        boundPath.clear();
+    }
+
+    LocalSocket accept()
+    {
+        return LocalSocket(::accept(handle, nullptr, nullptr));
+    }
+
+    bool sendAll(const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+#ifdef MSG_NOSIGNAL
+            int sent = ::send(handle, data, static_cast<int>(size), MSG_NOSIGNAL);
+#else
+            int sent = ::send(handle, data, static_cast<int>(size), 0);
+#endif
+            if (sent <= 0)
+            {
+#ifndef _WIN32
+                if (sent < 0 && errno == EINTR) continue;
+#endif
+                return false;
+            }
+            data += sent;
+            size -= sent;
+        }
+        return true;
+    }
+
+    bool sendLine(const std::string& line)
+    {
+        std::string framed = line;
+        framed += '\n';
+        return sendAll(framed.data(), framed.size());
+    }
+
+    // Next line without its '\n' (or "\r\n"); false at end of stream.
+    bool readLine(std::string& line)
+    {
+        for (;;)
+        {
+            size_t end = buffer.find('\n');
+            if (end != std::string::npos)
+            {
+                line.assign(buffer, 0, end > 0 && buffer[end - 1] == '\r' ? end - 1 : end);
+                buffer.erase(0, end + 1);
+                return true;
+            }
+            char chunk[4096];
+            int received = ::recv(handle, chunk, sizeof chunk, 0);
+            if (received <= 0)
+            {
+#ifndef _WIN32
+                if (received < 0 && errno == EINTR) continue;
+#endif
+                return false;
+            }
+            buffer.append(chunk, received);
+        }
+    }
+
+    // Wakes any thread blocked reading from or accepting on this socket.
+    void shutdown()
+    {
+#ifdef _WIN32
+        if (isOpen()) ::shutdown(handle, SD_BOTH);
+#else
+        if (isOpen()) ::shutdown(handle, SHUT_RDWR);
+#endif
+    }
+
+    void close()
+    {
+        if (!isOpen()) return;
+#ifdef _WIN32
+        closesocket(handle);
+#else
+        ::close(handle);
+#endif
+        handle = kInvalid;
+        buffer.clear();
+    }
+
+private:
+    Handle handle = kInvalid;
+    std::string buffer;
+    std::string boundPath;
+    std::pair<unsigned long long, unsigned long long> boundFile{0, 0};
+
+    // Tells files at one path apart: device and inode, or on Windows the
+    // creation time. Zeros if there is no file.
+    static std::pair<unsigned long long, unsigned long long> fileIdentity(const std::string& path)
+    {
+#ifdef _WIN32
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data)) return {0, 0};
+        return {data.ftCreationTime.dwHighDateTime, data.ftCreationTime.dwLowDateTime};
+#else
+        struct stat file;
+        if (::lstat(path.c_str(), &file) != 0) return {0, 0};
+        return {static_cast<unsigned long long>(file.st_dev), static_cast<unsigned long long>(file.st_ino)};
+#endif
+    }
+
+    bool open(const std::string& path, sockaddr_un& address)
+    {
+        close();
+#ifdef _WIN32
+        static bool started = [] {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+        if (!started) return false;
+#endif
+        std::memset(&address, 0, sizeof address);
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof address.sun_path) return false;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        handle = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        return isOpen();
+    }
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <limits>
+
+// Axis-aligned box in map coordinates.
+struct MapRect
+{
+    float left;
+    float top;
+    float right;
+    float bottom;
+
+    bool intersects(const MapRect& o) const
+    {
+        return left <= o.right && o.left <= right && top <= o.bottom && o.top <= bottom;
+    }
+
+    bool contains(const MapRect& o) const
+    {
+        return left <= o.left && o.right <= right && top <= o.top && o.bottom <= bottom;
+    }
+
+    void extend(const MapRect& o)
+    {
+        left = std::min(left, o.left);
+        top = std::min(top, o.top);
+        right = std::max(right, o.right);
+        bottom = std::max(bottom, o.bottom);
+    }
+};
+
+// Loose quadtree over boxes (airport markers with their labels, edge
+// extents) for view culling. An item goes to the quadrant holding its
+// center as long as it is no larger than that quadrant, so long edges stay
+// near the root and small items sink to the leaves however they straddle
+// the splits; every node keeps the tight bounds of its subtree.
+//
+// Building also fixes an order of the items: each node's items, followed
+// by its subtrees, are one contiguous run of positions. A renderer that
+// lays its vertices out in that order can draw any query result as a few
+// ranges of one buffer; query() returns them as (first, count) runs of
+// positions and only looks at the items of nodes that straddle the view
+// edge. Runs less than kMergeGap apart are merged: drawing a few culled
+// items is cheaper than another draw call.
+struct MapQuadtree
+{
+    static const int kLeafSize = 32;
+    static const int kMaxDepth = 16;
+    static const int kMergeGap = 8;
+
+    std::vector<int> order;    // item at each position
+
+    void build(const std::vector<MapRect>& items)
+    {
+        nodes.clear();
+        order.clear();
+        boxes.clear();
+        if (items.empty()) return;
+
+        MapRect all = items[0];
+        for (const MapRect& box : items) all.extend(box);
+        std::vector<int> ids(items.size());
+        for (size_t i = 0; i < ids.size(); ++i) ids[i] = static_cast<int>(i);
+        order.reserve(items.size());
+        buildNode(items, ids, all, 0);
+
+        boxes.resize(order.size());
+        for (size_t p = 0; p < order.size(); ++p) boxes[p] = items[order[p]];
+    }
+
+    int size() const { return static_cast<int>(order.size()); }
+
+    // Runs of positions covering the items that intersect view; returns
+    // how many items that is.
+    int query(const MapRect& view, std::vector<std::pair<int, int>>& runs) const
+    {
+        runs.clear();
+        if (nodes.empty()) return 0;
+        int visible = 0;
+        int stack[4 * kMaxDepth + 4];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node& node = nodes[stack[--top]];
+            if (!view.intersects(node.bounds)) continue;
+            if (view.contains(node.bounds))
+            {
+                addRun(runs, node.begin, node.end - node.begin);
+                visible += node.end - node.begin;
+                continue;
+            }
+            for (int p = node.begin; p < node.ownEnd; ++p)
+            {
+                if (!view.intersects(boxes[p])) continue;
+                addRun(runs, p, 1);
+                ++visible;
+            }
+            // Pushed in reverse so runs come out in position order.
+            for (int c = 3; c >= 0; --c)
+                if (node.child[c] >= 0) stack[top++] = node.child[c];
+        }
+        return visible;
+    }
+
+private:
+    struct Node
+    {
+        MapRect bounds;    // tight bounds of every item in the subtree
+        int begin;
+        int ownEnd;
+        int end;
+        int child[4];
+    };
+
+    std::vector<Node> nodes;
+    std::vector<MapRect> boxes;    // by position
+
+    static void addRun(std::vector<std::pair<int, int>>& runs, int first, int count)
+    {
+        if (!runs.empty() && first - (runs.back().first + runs.back().second) <= kMergeGap)
+            runs.back().second = first + count - runs.back().first;
+        else runs.push_back({first, count});
+    }
+
+    int buildNode(const std::vector<MapRect>& items, std::vector<int>& ids, const MapRect& region, int depth)
+    {
+        int index = static_cast<int>(nodes.size());
+        const float inf = std::numeric_limits<float>::infinity();
+        MapRect bounds = {inf, inf, -inf, -inf};
+        nodes.push_back(Node{bounds, static_cast<int>(order.size()), 0, 0, {-1, -1, -1, -1}});
+
+        float midX = 0.5f * (region.left + region.right), midY = 0.5f * (region.top + region.bottom);
+        std::vector<int> quadrant[4];
+        if (static_cast<int>(ids.size()) > kLeafSize && depth < kMaxDepth)
+        {
+            float halfWidth = midX - region.left, halfHeight = midY - region.top;
+            std::vector<int> own;
+            for (int id : ids)
+            {
+                const MapRect& box = items[id];
+                if (box.right - box.left > halfWidth || box.bottom - box.top > halfHeight)
+                {
+                    own.push_back(id);
+                    continue;
+                }
+                bool east = box.left + box.right >= 2 * midX, south = box.top + box.bottom >= 2 * midY;
+                quadrant[(east ? 1 : 0) + (south ? 2 : 0)].push_back(id);
+            }
+            ids.swap(own);
+        }
+
+        for (int id : ids)
+        {
+            order.push_back(id);
+            bounds.extend(items[id]);
+        }
+        nodes[index].ownEnd = static_cast<int>(order.size());
+
+        for (int q = 0; q < 4; ++q)
+        {
+            if (quadrant[q].empty()) continue;
+            MapRect sub = {q & 1 ? midX : region.left, q & 2 ? midY : region.top,
+                           q & 1 ? region.right : midX, q & 2 ? region.bottom : midY};
+            int child = buildNode(items, quadrant[q], sub, depth + 1);
+            nodes[index].child[q] = child;
+            bounds.extend(nodes[child].bounds);
+        }
+        nodes[index].bounds = bounds;
+        nodes[index].end = static_cast<int>(order.size());
+        return index;
+    }
+};
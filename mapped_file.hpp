@@ -0,0 +1,98 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include <sys/stat.h>
+
+// Memory mapping of a whole file. Parsers work directly on the mapped
+// bytes, so loading never copies the file or allocates per field.
+// A copy-on-write mapping can be written to; the changes stay private to
+// the process and never reach the file.
+struct MappedFile
+{
+    char* data = nullptr;
+    size_t size = 0;
+
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path, bool copyOnWrite = false) { open(path, copyOnWrite); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, bool copyOnWrite = false)
+    {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER length;
+        if (!GetFileSizeEx(file, &length)) return close(), false;
+        size = static_cast<size_t>(length.QuadPart);
+        if (size == 0) return data = empty, true;
+        mapping = CreateFileMappingA(file, nullptr, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) return close(), false;
+        data = static_cast<char*>(MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+        if (!data) return close(), false;
+#else
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0) return close(), false;
+        size = static_cast<size_t>(info.st_size);
+        if (size == 0) return data = empty, true;
+        int protection = copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+        void* p = mmap(nullptr, size, protection, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) return close(), false;
+        if (!copyOnWrite) madvise(p, size, MADV_SEQUENTIAL);
+        data = static_cast<char*>(p);
+#endif
+        return true;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (data && size) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data && size) munmap(data, size);
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+private:
+    char empty[1] = {0};
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+// Last modification time of path in seconds, or -1 if it does not exist.
+inline long long fileModifiedTime(const std::string& path)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return -1;
+    return static_cast<long long>(info.st_mtime);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "flight_graph.hpp"
+#include "csv_loader.hpp"
+#include <unordered_map>
+
+// Map the airports are projected onto (the simulator window).
+const float kMapWidth = 900.0f;
+const float kMapHeight = 650.0f;
+const float kMapMargin = 25.0f;
+
+// Equirectangular projection of latitude/longitude onto the map.
+inline MapPoint projectToMap(double latitude, double longitude)
+{
+    float x = kMapMargin + static_cast<float>((longitude + 180.0) / 360.0) * (kMapWidth - 2 * kMapMargin);
+    float y = kMapMargin + static_cast<float>((90.0 - latitude) / 180.0) * (kMapHeight - 2 * kMapMargin);
+    return {x, y};
+}
+
+// Builds graph from an OpenFlights airports file and routes file. Each
+// file is memory-mapped and parsed once; routes are resolved by airport id
+// (falling back to the code), merged into one undirected edge per airport
+// pair and weighted by map distance. Routes to unknown airports are
+// counted as skipped.
+inline bool loadNetworkCsv(const std::string& airportsPath, const std::string& routesPath, FlightGraph& graph,
+                           CsvLoadStats* stats = nullptr)
+{
+    graph = FlightGraph();
+    CsvLoadStats local;
+    CsvLoadStats& s = stats ? *stats : local;
+    auto start = std::chrono::steady_clock::now();
+    double earlierSeconds = s.seconds;
+
+    std::vector<int> indexOfId;
+    bool ok = forEachAirport(airportsPath, [&](const AirportRecord& record) {
+        if (record.id >= 0)
+        {
+            if (record.id >= static_cast<int>(indexOfId.size())) indexOfId.resize(record.id + 1, -1);
+            indexOfId[record.id] = graph.airportCount();
+        }
+        MapPoint p = projectToMap(record.latitude, record.longitude);
+        graph.addAirport(std::string(record.code), p.x, p.y);
+    }, &s);
+    if (!ok) return false;
+
+    // Views into graph.airports, which no longer grows.
+    std::unordered_map<std::string_view, int> indexOfCode;
+    indexOfCode.reserve(graph.airports.size());
+    for (int i = 0; i < graph.airportCount(); ++i)
+        indexOfCode.emplace(graph.airports[i].code, i);
+
+    auto resolve = [&](int id, std::string_view code) {
+        if (id >= 0 && id < static_cast<int>(indexOfId.size()) && indexOfId[id] >= 0) return indexOfId[id];
+        auto it = indexOfCode.find(code);
+        return it == indexOfCode.end() ? -1 : it->second;
+    };
+
+    std::vector<std::uint64_t> links;
+    int unresolved = 0;
+    ok = forEachRoute(routesPath, [&](const RouteRecord& record) {
+        int u = resolve(record.sourceId, record.sourceCode);
+        int v = resolve(record.destinationId, record.destinationCode);
+        if (u < 0 || v < 0 || u == v)
+        {
+            ++unresolved;
+            return;
+        }
+        if (u > v) std::swap(u, v);
+        links.push_back(static_cast<std::uint64_t>(u) << 32 | static_cast<std::uint32_t>(v));
+    }, &s);
+    if (!ok) return false;
+
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end()), links.end());
+    graph.reserveEdges(links.size());
+    for (std::uint64_t link : links)
+    {
+        int u = static_cast<int>(link >> 32);
+        int v = static_cast<int>(link & 0xffffffffu);
+        graph.addEdge(u, v, graph.straightLineDistance(u, v));
+    }
+    graph.finalize();
+
+    s.routes -= unresolved;
+    s.skipped += unresolved;
+    // Whole load, including the edge merge, not just the two parses.
+    s.seconds = earlierSeconds + std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+// Splits the next blank-separated token off the front of rest; empty once
+// rest holds nothing but blanks.
+inline std::string_view nextToken(std::string_view& rest)
+{
+    size_t first = rest.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos)
+    {
+        rest = std::string_view();
+        return rest;
+    }
+    size_t last = rest.find_first_of(" \t\r", first);
+    if (last == std::string_view::npos) last = rest.size();
+    std::string_view token = rest.substr(first, last - first);
+    rest.remove_prefix(last);
+    return token;
+}
+
+// Resolves airports named in text input, by index or by code. Holds views
+// into graph.airports, which must not change while it is in use.
+struct AirportLookup
+{
+    explicit AirportLookup(const FlightGraph& graph) : count(graph.airportCount())
+    {
+        indexOfCode.reserve(graph.airports.size());
+        for (int i = 0; i < count; ++i)
+            indexOfCode.emplace(graph.airports[i].code, i);
+    }
+
+    // Airport index, or -1 if token names no airport.
+    int find(std::string_view token) const
+    {
+        int index;
+        if (parseCsvInt(token, index)) return index >= 0 && index < count ? index : -1;
+        auto it = indexOfCode.find(token);
+        return it == indexOfCode.end() ? -1 : it->second;
+    }
+
+private:
+    int count;
+    std::unordered_map<std::string_view, int> indexOfCode;
+};
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include "flight_graph.hpp"
+#include "map_quadtree.hpp"
+#include "fleet_simulation.hpp"
+#include <cmath>
+
+// The network drawn as retained vertex layers: edges as lines, airports as
+// small discs and labels as glyph quads textured from the font's atlas.
+// Everything is built once, edge colors included: the weather is applied
+// before the window opens and does not change while it is shown.
+//
+// Each layer's vertices are laid out in the order of a MapQuadtree, so a
+// frame only submits the ranges that intersect the view. Edges are split
+// into levels by length and a level is skipped once its longest edges
+// would be shorter than minEdgePixels on screen; labels are skipped while
+// more than labelBudget airports are in view. Zoomed out, that leaves the
+// long-haul edges and the airport markers.
+//
+// Layers live in a vertex buffer on the GPU where the driver supports it,
+// and are drawn from the vertex arrays otherwise.
+struct SceneLayer
+{
+    SceneLayer(sf::PrimitiveType primitive, sf::VertexBuffer::Usage usage)
+        : type(primitive), buffer(primitive, usage)
+    {
+    }
+
+    std::vector<sf::Vertex> vertices;
+
+    void upload()
+    {
+        buffered = sf::VertexBuffer::isAvailable() && !vertices.empty() &&
+                   buffer.create(vertices.size()) && buffer.update(vertices.data());
+    }
+
+    void draw(sf::RenderTarget& target, const sf::RenderStates& states, size_t first, size_t count) const
+    {
+        if (count == 0) return;
+        if (buffered) target.draw(buffer, first, count, states);
+        else target.draw(vertices.data() + first, count, type, states);
+    }
+
+private:
+    sf::PrimitiveType type;
+    sf::VertexBuffer buffer;
+    bool buffered = false;
+};
+
+const int kDiscSegments = 12;
+const int kDiscVertices = 3 * kDiscSegments;
+
+// Appends a filled circle as kDiscSegments triangles.
+inline void appendDisc(std::vector<sf::Vertex>& out, sf::Vector2f center, float radius, sf::Color color)
+{
+    static const auto corners = [] {
+        std::vector<sf::Vector2f> c(kDiscSegments + 1);
+        for (int k = 0; k <= kDiscSegments; ++k)
+        {
+            float angle = 2.0f * 3.14159265f * k / kDiscSegments;
+            c[k] = sf::Vector2f(std::cos(angle), std::sin(angle));
+        }
+        return c;
+    }();
+    for (int k = 0; k < kDiscSegments; ++k)
+    {
+        out.emplace_back(center, color);
+        out.emplace_back(center + corners[k] * radius, color);
+        out.emplace_back(center + corners[k + 1] * radius, color);
+    }
+}
+
+// Appends text as two triangles per glyph, laid out the way sf::Text does
+// (origin at the top left, baseline one character size down). Draw with
+// the font's texture for that size.
+inline void appendGlyphs(std::vector<sf::Vertex>& out, const sf::Font& font, unsigned size,
+                         const std::string& text, sf::Vector2f origin, sf::Color color)
+{
+    float x = origin.x;
+    float baseline = origin.y + static_cast<float>(size);
+    sf::Uint32 previous = 0;
+    for (char ch : text)
+    {
+        sf::Uint32 c = static_cast<unsigned char>(ch);
+        x += font.getKerning(previous, c, size);
+        previous = c;
+        const sf::Glyph& glyph = font.getGlyph(c, size, false);
+
+        float left = x + glyph.bounds.left, top = baseline + glyph.bounds.top;
+        float right = left + glyph.bounds.width, bottom = top + glyph.bounds.height;
+        float u0 = static_cast<float>(glyph.textureRect.left), v0 = static_cast<float>(glyph.textureRect.top);
+        float u1 = u0 + glyph.textureRect.width, v1 = v0 + glyph.textureRect.height;
+
+        out.emplace_back(sf::Vector2f(left, top), color, sf::Vector2f(u0, v0));
+        out.emplace_back(sf::Vector2f(right, top), color, sf::Vector2f(u1, v0));
+        out.emplace_back(sf::Vector2f(left, bottom), color, sf::Vector2f(u0, v1));
+        out.emplace_back(sf::Vector2f(left, bottom), color, sf::Vector2f(u0, v1));
+        out.emplace_back(sf::Vector2f(right, top), color, sf::Vector2f(u1, v0));
+        out.emplace_back(sf::Vector2f(right, bottom), color, sf::Vector2f(u1, v1));
+        x += glyph.advance;
+    }
+}
+
+// Rewrites out with every aircraft of the snapshot, blend of the way from
+// its previous to its current position, as one triangle of the given
+// radius pointing along its heading (the old airplane marker's shape), so
+// the whole fleet is a single draw. Aircraft highlight, if any, gets
+// highlightColor.
+inline void fleetVertices(const FleetSnapshot& fleet, float blend, std::vector<sf::Vertex>& out, float radius,
+                          sf::Color color, int highlight = -1, sf::Color highlightColor = sf::Color::White)
+{
+    const float back = 0.5f * radius, side = 0.8660254f * radius;
+    out.resize(3 * static_cast<size_t>(fleet.size()));
+    for (int a = 0; a < fleet.size(); ++a)
+    {
+        float x = fleet.previousX[a] + (fleet.x[a] - fleet.previousX[a]) * blend;
+        float y = fleet.previousY[a] + (fleet.y[a] - fleet.previousY[a]) * blend;
+        float dx = fleet.dirX[a], dy = fleet.dirY[a];
+        sf::Color c = a == highlight ? highlightColor : color;
+        out[3 * a] = sf::Vertex(sf::Vector2f(x + dx * radius, y + dy * radius), c);
+        out[3 * a + 1] = sf::Vertex(sf::Vector2f(x - dx * back - dy * side, y - dy * back + dx * side), c);
+        out[3 * a + 2] = sf::Vertex(sf::Vector2f(x - dx * back + dy * side, y - dy * back - dx * side), c);
+    }
+}
+
+// What the last cull() left in view.
+struct SceneFrameStats
+{
+    int airports = 0;
+    int edges = 0;
+    int edgeLevels = 0;
+    int ranges = 0;
+    bool labels = false;
+};
+
+struct NetworkScene
+{
+    // Edge level l holds edges up to kShortestLevel * 2^(l+1) map units
+    // long; the last level takes everything longer.
+    static const int kEdgeLevels = 8;
+    static constexpr float kShortestLevel = 4.0f;
+
+    sf::Color availableColor = sf::Color(100, 255, 100);
+    sf::Color unavailableColor = sf::Color(255, 80, 80);
+    sf::Color airportColor = sf::Color(50, 120, 250);
+    sf::Color labelColor = sf::Color::White;
+    float airportRadius = 8.0f;
+    unsigned labelSize = 14;
+    float minEdgePixels = 12.0f;
+    int labelBudget = 300;
+
+    // Airport markers keep the old CircleShape placement: the disc's
+    // bounding box starts at the airport position.
+    sf::Vector2f airportCenter(const MapPoint& p) const
+    {
+        return sf::Vector2f(p.x + airportRadius, p.y + airportRadius);
+    }
+
+    void build(const FlightGraph& graph, const sf::Font& labelFont)
+    {
+        font = &labelFont;
+        int n = graph.airportCount();
+
+        // Airports, with each item's box covering its marker and its label.
+        std::vector<std::vector<sf::Vertex>> glyphs(n);
+        std::vector<MapRect> boxes(n);
+        for (int i = 0; i < n; ++i)
+        {
+            const MapPoint& p = graph.airports[i].position;
+            appendGlyphs(glyphs[i], labelFont, labelSize, graph.airports[i].code, sf::Vector2f(p.x + 12, p.y - 5),
+                         labelColor);
+            boxes[i] = {p.x, p.y, p.x + 2 * airportRadius, p.y + 2 * airportRadius};
+            for (const sf::Vertex& v : glyphs[i])
+                boxes[i].extend({v.position.x, v.position.y, v.position.x, v.position.y});
+        }
+        airportTree.build(boxes);
+
+        airports.vertices.clear();
+        airports.vertices.reserve(static_cast<size_t>(n) * kDiscVertices);
+        labels.vertices.clear();
+        labelStart.assign(1, 0);
+        for (int i : airportTree.order)
+        {
+            appendDisc(airports.vertices, airportCenter(graph.airports[i].position), airportRadius, airportColor);
+            labels.vertices.insert(labels.vertices.end(), glyphs[i].begin(), glyphs[i].end());
+            labelStart.push_back(static_cast<int>(labels.vertices.size()));
+        }
+
+        // Edges, bucketed by length.
+        std::vector<int> edgeIds[kEdgeLevels];
+        for (int e = 0; e < graph.edgeCount(); ++e)
+        {
+            const MapPoint& a = graph.airports[graph.edgeFrom[e]].position;
+            const MapPoint& b = graph.airports[graph.edgeTo[e]].position;
+            float length = std::hypot(b.x - a.x, b.y - a.y);
+            int level = 0;
+            while (level + 1 < kEdgeLevels && length > kShortestLevel * float(2 << level)) ++level;
+            edgeIds[level].push_back(e);
+        }
+        for (int level = 0; level < kEdgeLevels; ++level)
+        {
+            EdgeLevel& bucket = edges[level];
+            boxes.clear();
+            for (int e : edgeIds[level])
+            {
+                const MapPoint& a = graph.airports[graph.edgeFrom[e]].position;
+                const MapPoint& b = graph.airports[graph.edgeTo[e]].position;
+                boxes.push_back({std::min(a.x, b.x), std::min(a.y, b.y), std::max(a.x, b.x), std::max(a.y, b.y)});
+            }
+            bucket.tree.build(boxes);
+
+            bucket.layer.vertices.resize(2 * edgeIds[level].size());
+            for (int p = 0; p < bucket.tree.size(); ++p)
+            {
+                int e = edgeIds[level][bucket.tree.order[p]];
+                sf::Color color = graph.isAvailable(e) ? availableColor : unavailableColor;
+                const MapPoint& a = graph.airports[graph.edgeFrom[e]].position;
+                const MapPoint& b = graph.airports[graph.edgeTo[e]].position;
+                bucket.layer.vertices[2 * p] = sf::Vertex(sf::Vector2f(a.x, a.y), color);
+                bucket.layer.vertices[2 * p + 1] = sf::Vertex(sf::Vector2f(b.x, b.y), color);
+            }
+            bucket.layer.upload();
+        }
+
+        airports.upload();
+        labels.upload();
+    }
+
+    // Picks what the next frame draws: the parts of each layer inside view,
+    // at the detail its scale (pixels across) allows.
+    void cull(const sf::View& view, float pixelWidth)
+    {
+        sf::Vector2f center = view.getCenter(), size = view.getSize();
+        MapRect visible = {center.x - 0.5f * size.x, center.y - 0.5f * size.y,
+                           center.x + 0.5f * size.x, center.y + 0.5f * size.y};
+        float pixelsPerUnit = size.x > 0.0f ? pixelWidth / size.x : 1.0f;
+
+        stats = SceneFrameStats();
+        stats.airports = airportTree.query(visible, airportRuns);
+        stats.labels = stats.airports <= labelBudget;
+        stats.ranges = static_cast<int>(airportRuns.size()) * (stats.labels ? 2 : 1);
+        for (int level = 0; level < kEdgeLevels; ++level)
+        {
+            EdgeLevel& bucket = edges[level];
+            bucket.runs.clear();
+            bool lastLevel = level + 1 == kEdgeLevels;
+            if (!lastLevel && kShortestLevel * float(2 << level) * pixelsPerUnit < minEdgePixels) continue;
+            stats.edges += bucket.tree.query(visible, bucket.runs);
+            stats.ranges += static_cast<int>(bucket.runs.size());
+            ++stats.edgeLevels;
+        }
+    }
+
+    const SceneFrameStats& frameStats() const { return stats; }
+
+    // Edges and airports; labels are a separate pass so that markers drawn
+    // in between stay under them.
+    void drawNetwork(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default) const
+    {
+        for (const EdgeLevel& bucket : edges)
+            for (const auto& run : bucket.runs)
+                bucket.layer.draw(target, states, 2 * static_cast<size_t>(run.first), 2 * static_cast<size_t>(run.second));
+        for (const auto& run : airportRuns)
+            airports.draw(target, states, static_cast<size_t>(run.first) * kDiscVertices,
+                          static_cast<size_t>(run.second) * kDiscVertices);
+    }
+
+    void drawLabels(sf::RenderTarget& target, sf::RenderStates states = sf::RenderStates::Default) const
+    {
+        if (!font || !stats.labels) return;
+        states.texture = &font->getTexture(labelSize);
+        for (const auto& run : airportRuns)
+            labels.draw(target, states, labelStart[run.first], labelStart[run.first + run.second] - labelStart[run.first]);
+    }
+
+private:
+    struct EdgeLevel
+    {
+        MapQuadtree tree;
+        SceneLayer layer{sf::Lines, sf::VertexBuffer::Static};
+        std::vector<std::pair<int, int>> runs;
+    };
+
+    EdgeLevel edges[kEdgeLevels];
+    MapQuadtree airportTree;
+    SceneLayer airports{sf::Triangles, sf::VertexBuffer::Static};
+    SceneLayer labels{sf::Triangles, sf::VertexBuffer::Static};
+    std::vector<int> labelStart;    // by airport position, plus the end
+    std::vector<std::pair<int, int>> airportRuns;
+    const sf::Font* font = nullptr;
+    SceneFrameStats stats;
+};
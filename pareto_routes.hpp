@@ -0,0 +1,388 @@
+#pragma once
+
+#include "route_batch.hpp"
+#include <array>
+#include <string>
+
+// Multi-criteria routing: instead of the one shortest route, every route
+// that no other beats on all criteria at once (the Pareto set), e.g. a
+// slightly longer route with less storm risk or a cheaper one with one
+// more leg.
+//
+// The search is label-correcting. A label is one partial route: its cost
+// vector, airport and parent label. Each airport keeps its Pareto set of
+// labels sorted by the first criterion, so a new label can only be
+// dominated by a prefix of the set and can only dominate a suffix. Open
+// labels wait in a bucket queue keyed on the first criterion, which
+// expands them roughly in order of that criterion and keeps corrections
+// rare. Labels dominated by one already at the destination are dropped.
+//
+// Labels live in a pool of at most maxLabels entries; a search that would
+// need more stops and reports itself truncated, returning the routes it
+// found so far.
+
+enum class Criterion
+{
+    Distance,       // map distance
+    WeatherRisk,    // -log of the chance that every leg stays open
+    Fare,           // a per-leg base fare plus a distance rate varying by leg
+    Legs
+};
+
+const int kMaxCriteria = 4;
+
+inline const char* criterionName(Criterion c)
+{
+    switch (c)
+    {
+        case Criterion::WeatherRisk: return "risk";
+        case Criterion::Fare: return "fare";
+        case Criterion::Legs: return "legs";
+        default: return "distance";
+    }
+}
+
+inline bool parseCriterion(std::string_view name, Criterion& c)
+{
+    for (Criterion k : {Criterion::Distance, Criterion::WeatherRisk, Criterion::Fare, Criterion::Legs})
+    {
+        if (name == criterionName(k))
+        {
+            c = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+// A comma-separated list of criterion names, e.g. "distance,risk,fare".
+// False on an unknown name or more than kMaxCriteria of them.
+inline bool parseCriteria(std::string_view list, std::vector<Criterion>& kinds)
+{
+    kinds.clear();
+    while (!list.empty())
+    {
+        size_t comma = list.find(',');
+        Criterion c;
+        if (!parseCriterion(list.substr(0, comma), c) || kinds.size() == kMaxCriteria) return false;
+        kinds.push_back(c);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+    }
+    return !kinds.empty();
+}
+
+// Per-edge costs for each criterion, edge-major: edge e's costs are
+// cost[e * count() .. e * count() + count()).
+struct RouteCriteria
+{
+    std::vector<Criterion> kinds;
+    std::vector<float> cost;
+
+    int count() const { return static_cast<int>(kinds.size()); }
+};
+
+// Costs of kinds (at most kMaxCriteria) over graph's edges. Weather risk
+// comes from per-edge failure probabilities (none if not given).
+inline RouteCriteria makeRouteCriteria(const FlightGraph& graph, const std::vector<Criterion>& kinds,
+                                       const std::vector<float>* failureProbability = nullptr)
+{
+    RouteCriteria criteria;
+    criteria.kinds.assign(kinds.begin(), kinds.begin() + std::min<size_t>(kinds.size(), kMaxCriteria));
+    int k = criteria.count(), m = graph.edgeCount();
+    criteria.cost.resize(static_cast<size_t>(m) * k);
+    for (int e = 0; e < m; ++e)
+    {
+        for (int i = 0; i < k; ++i)
+        {
+            double value = 0.0;
+            switch (criteria.kinds[i])
+            {
+                case Criterion::Distance: value = graph.edgeWeight[e]; break;
+                case Criterion::WeatherRisk:
+                {
+                    double p = failureProbability ? std::min(0.999999, double((*failureProbability)[e])) : 0.0;
+                    value = -std::log1p(-p);
+                    break;
+                }
+                case Criterion::Fare:
+                {
+                    // Competition on a leg, fixed per edge: 0.6 to 1.4 times the rate.
+                    std::uint32_t h = static_cast<std::uint32_t>(e) * 2654435761u;
+                    h ^= h >> 15;
+                    value = 40.0 + 0.12 * graph.edgeWeight[e] * (0.6 + 0.8 * (h % 1024) / 1023.0);
+                    break;
+                }
+                case Criterion::Legs: value = 1.0; break;
+            }
+            criteria.cost[static_cast<size_t>(e) * k + i] = static_cast<float>(value);
+        }
+    }
+    return criteria;
+}
+
+struct ParetoRoute
+{
+    std::array<float, kMaxCriteria> cost{};
+    std::vector<int> path;
+};
+
+struct ParetoOptions
+{
+    int maxLabels = 1 << 21;      // label pool bound, 28 bytes each
+    double bucketWidth = 0.0;     // first-criterion width of a queue bucket; 0 picks the mean edge cost
+};
+
+struct ParetoStats
+{
+    long long created = 0;        // labels that entered an airport's set
+    long long expanded = 0;
+    long long rejected = 0;       // new labels dominated on arrival
+    long long removed = 0;        // labels later dominated by a new one
+    int largestSet = 0;           // labels at one airport at once
+    bool truncated = false;       // ran out of label pool
+    size_t poolBytes = 0;
+    double seconds = 0.0;
+};
+
+struct ParetoSearch
+{
+    ParetoSearch(const FlightGraph& g, const RouteCriteria& c, const ParetoOptions& o = ParetoOptions())
+        : graph(g), criteria(c), options(o), k(c.count())
+    {
+        width = options.bucketWidth;
+        if (width <= 0.0 && graph.edgeCount() > 0)
+        {
+            double total = 0.0;
+            for (int e = 0; e < graph.edgeCount(); ++e) total += criteria.cost[static_cast<size_t>(e) * k];
+            width = total / graph.edgeCount();
+        }
+        if (!(width > 0.0)) width = 1.0;
+        pool.reserve(std::min(options.maxLabels, 1 << 16));
+        sets.resize(graph.airportCount());
+    }
+
+    // The Pareto set from src to dst on the view's weather, ordered by the
+    // first criterion.
+    void search(const GraphView& view, int src, int dst, std::vector<ParetoRoute>& routes, ParetoStats* stats = nullptr)
+    {
+        ParetoStats local;
+        ParetoStats& st = stats ? *stats : local;
+        st = ParetoStats();
+        auto start = std::chrono::steady_clock::now();
+        routes.clear();
+        for (int v : touched) sets[v].clear();
+        touched.clear();
+        pool.clear();
+        for (std::vector<int>& bucket : buckets) bucket.clear();
+
+        Label first;
+        first.node = src;
+        first.parent = -1;
+        tryInsert(first, dst, st);
+        for (size_t b = 0; b < buckets.size() && !st.truncated; ++b)
+        {
+            // Labels pushed while the bucket is processed land in it or later.
+            for (size_t i = 0; i < buckets[b].size() && !st.truncated; ++i)
+            {
+                int id = buckets[b][i];
+                if (pool[id].dead || pool[id].node == dst) continue;
+                ++st.expanded;
+                const Label label = pool[id];
+                for (int a = graph.arcOffset[label.node]; a < graph.arcOffset[label.node + 1]; ++a)
+                {
+                    int e = graph.arcEdge[a];
+                    if (!view.isAvailable(e)) continue;
+                    Label next;
+                    next.node = graph.arcTarget[a];
+                    next.parent = id;
+                    const float* add = &criteria.cost[static_cast<size_t>(e) * k];
+                    for (int i = 0; i < k; ++i) next.cost[i] = label.cost[i] + add[i];
+                    tryInsert(next, dst, st);
+                    if (st.truncated) break;
+                }
+            }
+        }
+
+        for (int id : sets[dst])
+        {
+            ParetoRoute route;
+            route.cost = pool[id].cost;
+            for (int l = id; l >= 0; l = pool[l].parent) route.path.push_back(pool[l].node);
+            std::reverse(route.path.begin(), route.path.end());
+            routes.push_back(std::move(route));
+        }
+        st.poolBytes = pool.capacity() * sizeof(Label);
+        st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    struct Label
+    {
+        std::array<float, kMaxCriteria> cost{};
+        int node = -1;
+        int parent = -1;
+        bool dead = false;
+    };
+
+    const FlightGraph& graph;
+    const RouteCriteria& criteria;
+    ParetoOptions options;
+    int k;
+    double width = 1.0;
+    std::vector<Label> pool;
+    std::vector<std::vector<int>> sets;       // per airport, sorted by the first criterion
+    std::vector<int> touched;
+    std::vector<std::vector<int>> buckets;
+
+    // a is at least as good as b on every criterion.
+    bool dominates(const Label& a, const Label& b) const
+    {
+        for (int i = 0; i < k; ++i)
+            if (a.cost[i] > b.cost[i]) return false;
+        return true;
+    }
+
+    void tryInsert(const Label& label, int dst, ParetoStats& st)
+    {
+        // Routes no better than one already found are not worth extending.
+        if (label.node != dst)
+        {
+            for (int id : sets[dst])
+            {
+                if (pool[id].cost[0] > label.cost[0]) break;
+                if (dominates(pool[id], label))
+                {
+                    ++st.rejected;
+                    return;
+                }
+            }
+        }
+
+        std::vector<int>& set = sets[label.node];
+        auto at = std::upper_bound(set.begin(), set.end(), label.cost[0],
+                                   [this](float c, int id) { return c < pool[id].cost[0]; });
+        for (auto it = set.begin(); it != at; ++it)
+        {
+            if (dominates(pool[*it], label))
+            {
+                ++st.rejected;
+                return;
+            }
+        }
+        if (static_cast<int>(pool.size()) >= options.maxLabels)
+        {
+            st.truncated = true;
+            return;
+        }
+
+        // Only labels whose first cost is not below the new one's can be
+        // dominated by it.
+        size_t keep = std::lower_bound(set.begin(), at, label.cost[0],
+                                       [this](int id, float c) { return pool[id].cost[0] < c; }) - set.begin();
+        for (size_t i = keep; i < set.size(); ++i)
+        {
+            if (dominates(label, pool[set[i]]))
+            {
+                pool[set[i]].dead = true;
+                ++st.removed;
+            }
+            else
+            {
+                set[keep++] = set[i];
+            }
+        }
+        set.resize(keep);
+
+        int id = static_cast<int>(pool.size());
+        pool.push_back(label);
+        if (set.empty()) touched.push_back(label.node);
+        set.insert(std::upper_bound(set.begin(), set.end(), label.cost[0],
+                                    [this](float c, int l) { return c < pool[l].cost[0]; }),
+                   id);
+        st.largestSet = std::max(st.largestSet, static_cast<int>(set.size()));
+        ++st.created;
+
+        size_t bucket = static_cast<size_t>(label.cost[0] / width);
+        if (bucket >= buckets.size()) buckets.resize(bucket + 1);
+        buckets[bucket].push_back(id);
+    }
+};
+
+// Appends the JSON line (with its '\n') for the Pareto set of one query,
+// one object per route with its cost on each criterion (risk as the chance
+// that some leg closes) and its path.
+//
+//   {"src":"JFK","dst":"MIA","truncated":false,"routes":[
+//    {"distance":460.977,"risk":0.0199,"path":["JFK","MIA"]},
+//    {"distance":512.310,"risk":0.0101,"path":["JFK","ATL","MIA"]}]}
+inline void appendParetoJson(std::string& out, const FlightGraph& graph, const RouteCriteria& criteria, int src,
+                             int dst, const std::vector<ParetoRoute>& routes, bool truncated)
+{
+    char number[64];
+    out += "{\"src\":";
+    appendJsonString(out, graph.airports[src].code);
+    out += ",\"dst\":";
+    appendJsonString(out, graph.airports[dst].code);
+    out += truncated ? ",\"truncated\":true" : ",\"truncated\":false";
+    out += ",\"routes\":[";
+    for (size_t r = 0; r < routes.size(); ++r)
+    {
+        out += r ? ",{" : "{";
+        for (int i = 0; i < criteria.count(); ++i)
+        {
+            Criterion kind = criteria.kinds[i];
+            double value = kind == Criterion::WeatherRisk ? -std::expm1(-double(routes[r].cost[i])) : routes[r].cost[i];
+            int digits = kind == Criterion::WeatherRisk ? 4 : kind == Criterion::Legs ? 0 : 3;
+            std::snprintf(number, sizeof number, "%s\"%s\":%.*f", i ? "," : "", criterionName(kind), digits, value);
+            out += number;
+        }
+        out += ",\"path\":[";
+        for (size_t k = 0; k < routes[r].path.size(); ++k)
+        {
+            if (k) out += ',';
+            appendJsonString(out, graph.airports[routes[r].path[k]].code);
+        }
+        out += "]}";
+    }
+    out += "]}\n";
+}
+
+struct ParetoBatchStats
+{
+    long long queries = 0;
+    long long routes = 0;
+    long long labels = 0;
+    int truncated = 0;            // queries that ran out of label pool
+    double seconds = 0.0;
+};
+
+// Batch mode for Pareto routes: searches every query between endpoints on
+// criteria and writes one appendParetoJson line each to out, in order.
+// Returns false if out fails.
+inline bool runParetoBatch(const FlightGraph& graph, const RouteCriteria& criteria, const ParetoOptions& options,
+                           const std::vector<std::pair<int, int>>& endpoints, std::ostream& out,
+                           ParetoBatchStats* stats = nullptr)
+{
+    ParetoBatchStats local;
+    ParetoBatchStats& st = stats ? *stats : local;
+    st = ParetoBatchStats();
+
+    ParetoSearch search(graph, criteria, options);
+    GraphView view(graph);
+    std::vector<ParetoRoute> routes;
+    ParetoStats queryStats;
+    std::string buffer;
+    for (const auto& query : endpoints)
+    {
+        search.search(view, query.first, query.second, routes, &queryStats);
+        appendParetoJson(buffer, graph, criteria, query.first, query.second, routes, queryStats.truncated);
+        ++st.queries;
+        st.routes += routes.size();
+        st.labels += queryStats.created;
+        st.truncated += queryStats.truncated;
+        st.seconds += queryStats.seconds;
+    }
+    out.write(buffer.data(), buffer.size());
+    out.flush();
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <cstring>
+
+// Priority queues the routing engines can be instantiated with. All of them
+// share one interface:
+//   clear(n)       empty the queue for airport ids < n
+//   empty()
+//   push(key, v)   insert v, or lower its key if it is already queued
+//   topKey()       smallest key (queue must not be empty)
+//   pop()          remove and return the (key, v) with the smallest key
+// Lazy queues may return an airport more than once; the engines skip
+// entries for airports they have already settled.
+
+// Binary heap with lazy deletion: a decrease-key is a second insert.
+struct LazyHeap
+{
+    using Entry = std::pair<double, int>;
+    std::vector<Entry> items;
+
+    void clear(int) { items.clear(); }
+    bool empty() const { return items.empty(); }
+
+    void push(double key, int v)
+    {
+        items.push_back({key, v});
+        std::push_heap(items.begin(), items.end(), std::greater<>());
+    }
+
+    double topKey() const { return items.front().first; }
+
+    Entry pop()
+    {
+        std::pop_heap(items.begin(), items.end(), std::greater<>());
+        Entry top = items.back();
+        items.pop_back();
+        return top;
+    }
+};
+
+// Indexed 4-ary heap with a real decrease-key, so every airport is queued
+// at most once and no stale entries accumulate on dense graphs.
+struct QuaternaryHeap
+{
+    using Entry = std::pair<double, int>;
+    std::vector<Entry> items;
+    std::vector<int> position;
+
+    void clear(int n)
+    {
+        for (const Entry& e : items) position[e.second] = -1;
+        items.clear();
+        if (static_cast<int>(position.size()) < n) position.resize(n, -1);
+    }
+
+    bool empty() const { return items.empty(); }
+
+    void push(double key, int v)
+    {
+        int i = position[v];
+        if (i < 0)
+        {
+            i = static_cast<int>(items.size());
+            items.push_back({key, v});
+        }
+        else if (key < items[i].first)
+        {
+            items[i].first = key;
+        }
+        else
+        {
+            return;
+        }
+        siftUp(i);
+    }
+
+    double topKey() const { return items.front().first; }
+
+    Entry pop()
+    {
+        Entry top = items.front();
+        position[top.second] = -1;
+        Entry last = items.back();
+        items.pop_back();
+        if (!items.empty())
+        {
+            items[0] = last;
+            position[last.second] = 0;
+            siftDown(0);
+        }
+        return top;
+    }
+
+private:
+    void siftUp(int i)
+    {
+        Entry e = items[i];
+        while (i > 0)
+        {
+            int parent = (i - 1) / 4;
+            if (!(e.first < items[parent].first)) break;
+            items[i] = items[parent];
+            position[items[i].second] = i;
+            i = parent;
+        }
+        items[i] = e;
+        position[e.second] = i;
+    }
+
+    void siftDown(int i)
+    {
+        Entry e = items[i];
+        int n = static_cast<int>(items.size());
+        for (;;)
+        {
+            int first = 4 * i + 1;
+            if (first >= n) break;
+            int best = first;
+            int last = std::min(first + 4, n);
+            for (int c = first + 1; c < last; ++c)
+                if (items[c].first < items[best].first) best = c;
+            if (!(items[best].first < e.first)) break;
+            items[i] = items[best];
+            position[items[i].second] = i;
+            i = best;
+        }
+        items[i] = e;
+        position[e.second] = i;
+    }
+};
+
+// Monotone radix heap. Keys are mapped to an order-preserving 64-bit
+// integer (the IEEE-754 pattern with the sign handled), so bucketing is by
+// the highest bit that differs from the last extracted key and ordering is
+// exact. Keys must not drop below the last popped key; tiny violations from
+// floating-point rounding in A* potentials are clamped to it.
+struct RadixHeap
+{
+    using Entry = std::pair<double, int>;
+
+    void clear(int)
+    {
+        for (auto& b : buckets) b.clear();
+        last = 0;
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+
+    void push(double key, int v)
+    {
+        std::uint64_t code = std::max(encode(key), last);
+        buckets[bucketOf(code)].push_back({code, key, v});
+        ++count;
+    }
+
+    double topKey()
+    {
+        refill();
+        return buckets[0].back().key;
+    }
+
+    Entry pop()
+    {
+        refill();
+        Item item = buckets[0].back();
+        buckets[0].pop_back();
+        --count;
+        return {item.key, item.v};
+    }
+
+private:
+    struct Item
+    {
+        std::uint64_t code;
+        double key;
+        int v;
+    };
+
+    std::vector<Item> buckets[65];
+    std::uint64_t last = 0;
+    size_t count = 0;
+
+    static std::uint64_t encode(double key)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &key, sizeof bits);
+        return (bits >> 63) ? ~bits : bits | (1ull << 63);
+    }
+
+    int bucketOf(std::uint64_t code) const
+    {
+        std::uint64_t diff = code ^ last;
+        if (diff == 0) return 0;
+#if defined(__GNUC__)
+        return 64 - __builtin_clzll(diff);
+#else
+        int b = 0;
+        while (diff) { diff >>= 1; ++b; }
+        return b;
+#endif
+    }
+
+    // Moves the smallest keys into bucket 0 by re-spreading the first
+    // non-empty bucket around its minimum.
+    void refill()
+    {
+        if (!buckets[0].empty()) return;
+        int i = 1;
+        while (buckets[i].empty()) ++i;
+
+        std::uint64_t smallest = buckets[i][0].code;
+        for (const Item& item : buckets[i])
+            smallest = std::min(smallest, item.code);
+        last = smallest;
+
+        for (const Item& item : buckets[i])
+            buckets[bucketOf(item.code)].push_back(item);
+        buckets[i].clear();
+    }
+};
@@ -0,0 +1,282 @@
+#pragma once
+
+#include "network_loader.hpp"
+#include "contraction_hierarchy.hpp"
+#include "thread_pool.hpp"
+#include <istream>
+#include <ostream>
+#include <cstdio>
+
+// Headless batch routing. Queries are read one per line,
+//
+//   <airport> <airport>        airports by index or code
+//   # comment
+//
+// and answered in blocks on a thread pool with the simulator's logic: the
+// direct route ignores weather, and only if it crosses bad weather is the
+// weather-aware route searched (otherwise the two are the same route).
+// Results are written in input order, either as JSON lines
+//
+//   {"src":"JFK","dst":"MIA","found":true,"blocked":false,"rerouted":false,
+//    "distance":460.977,"direct":460.977,"path":["JFK","MIA"]}
+//
+// (one line each; unknown airports give {"src":..,"dst":..,"error":..})
+// or as binary: the 8-byte magic "AERORT01", then per query a
+// RouteResultHeader followed by hops int32 airport indices.
+const char kRouteResultMagic[8] = {'A', 'E', 'R', 'O', 'R', 'T', '0', '1'};
+
+enum class BatchFormat
+{
+    Json,
+    Binary
+};
+
+enum RouteResultFlags : std::uint32_t
+{
+    ResultFound = 1,      // a weather-aware route exists
+    ResultBlocked = 2,    // the direct route crosses bad weather
+    ResultRerouted = 4,   // blocked, and a detour was found
+    ResultInvalid = 8     // the query named an unknown airport
+};
+
+struct RouteResultHeader
+{
+    std::int32_t src;
+    std::int32_t dst;
+    std::uint32_t flags;
+    std::uint32_t hops;
+    double distance;
+    double direct;
+};
+
+struct BatchOptions
+{
+    SearchMode mode = SearchMode::Dijkstra;
+    bool useHierarchy = false;
+    BatchFormat format = BatchFormat::Json;
+    int blockSize = 4096;
+    unsigned threads = 0;
+};
+
+struct BatchStats
+{
+    long long queries = 0;
+    long long invalid = 0;
+    long long found = 0;
+    long long rerouted = 0;
+    double seconds = 0.0;
+
+    double queriesPerSecond() const { return seconds > 0.0 ? queries / seconds : 0.0; }
+};
+
+inline void appendJsonString(std::string& out, std::string_view text)
+{
+    out += '"';
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    out += '"';
+}
+
+struct RouteResult
+{
+    std::uint32_t flags = 0;
+    double distance = -1.0;
+    double direct = -1.0;
+    std::vector<int> path;
+};
+
+// Answers one query the simulator's way. view is the weather-aware view
+// (possibly with extra closed edges); the direct route ignores weather.
+// When given, the hierarchies replace the searches; they must have been
+// customized for the direct and the weather-aware view respectively.
+inline void answerRoute(const GraphView& view, int src, int dst, SearchMode mode, RouteResult& result,
+                        std::vector<int>& directPath, std::vector<int>& edges,
+                        const ContractionHierarchy* directHierarchy = nullptr,
+                        const ContractionHierarchy* weatherHierarchy = nullptr)
+{
+    const FlightGraph& graph = *view.graph;
+    GraphView directView(graph);
+    directView.ignoreWeather = true;
+    SearchStats directStats, weatherStats;
+    if (directHierarchy) directHierarchy->query(src, dst, directPath, &directStats);
+    else directView.shortestPath(src, dst, directPath, mode, &directStats);
+
+    result.direct = directPath.empty() ? -1.0 : directStats.distance;
+    graph.pathEdges(directPath, edges);
+    bool blocked = view.overrides.empty() && !view.availableBits
+        ? anyEdgeUnavailable(graph.availableBits.data(), edges.data(), edges.size())
+        : std::any_of(edges.begin(), edges.end(), [&](int e) { return !view.isAvailable(e); });
+    if (!blocked)
+    {
+        result.path.swap(directPath);
+        result.distance = result.direct;
+        result.flags = result.path.empty() ? 0u : std::uint32_t(ResultFound);
+        return;
+    }
+    if (weatherHierarchy) weatherHierarchy->query(src, dst, result.path, &weatherStats);
+    else view.shortestPath(src, dst, result.path, mode, &weatherStats);
+    result.distance = result.path.empty() ? -1.0 : weatherStats.distance;
+    result.flags = ResultBlocked | (result.path.empty() ? 0 : ResultFound | ResultRerouted);
+}
+
+// Appends the JSON line (with its '\n') for an answered query.
+inline void appendRouteJson(std::string& out, const FlightGraph& graph, int src, int dst, const RouteResult& result)
+{
+    char number[32];
+    out += "{\"src\":";
+    appendJsonString(out, graph.airports[src].code);
+    out += ",\"dst\":";
+    appendJsonString(out, graph.airports[dst].code);
+    out += result.flags & ResultFound ? ",\"found\":true" : ",\"found\":false";
+    out += result.flags & ResultBlocked ? ",\"blocked\":true" : ",\"blocked\":false";
+    out += result.flags & ResultRerouted ? ",\"rerouted\":true" : ",\"rerouted\":false";
+    if (result.flags & ResultFound)
+    {
+        std::snprintf(number, sizeof number, "%.3f", result.distance);
+        out += ",\"distance\":";
+        out += number;
+    }
+    if (result.direct >= 0.0)
+    {
+        std::snprintf(number, sizeof number, "%.3f", result.direct);
+        out += ",\"direct\":";
+        out += number;
+    }
+    out += ",\"path\":[";
+    for (size_t k = 0; k < result.path.size(); ++k)
+    {
+        if (k) out += ',';
+        appendJsonString(out, graph.airports[result.path[k]].code);
+    }
+    out += "]}\n";
+}
+
+inline bool runRouteBatch(const FlightGraph& graph, std::istream& in, std::ostream& out,
+                          const BatchOptions& options, BatchStats* stats = nullptr)
+{
+    BatchStats local;
+    BatchStats& st = stats ? *stats : local;
+    st = BatchStats();
+    auto start = std::chrono::steady_clock::now();
+
+    GraphView directView(graph);
+    directView.ignoreWeather = true;
+    GraphView weatherView(graph);
+
+    // Both hierarchies share one ordering; only the customization differs.
+    ContractionHierarchy weatherHierarchy, directHierarchy;
+    if (options.useHierarchy)
+    {
+        weatherHierarchy.build(graph);
+        directHierarchy = weatherHierarchy;
+        directHierarchy.customize(directView);
+        weatherHierarchy.customize(weatherView);
+    }
+
+    struct Query
+    {
+        int src;
+        int dst;
+        std::string text;    // the original line, kept for invalid queries only
+        RouteResult result;
+    };
+
+    WorkStealingPool pool(options.threads);
+    std::vector<std::vector<int>> directPaths(pool.size()), pathEdges(pool.size());
+
+    if (options.format == BatchFormat::Binary) out.write(kRouteResultMagic, sizeof kRouteResultMagic);
+
+    AirportLookup airports(graph);
+    std::vector<Query> block(options.blockSize);
+    std::string line, buffer;
+    bool more = true;
+    while (more)
+    {
+        int count = 0;
+        while (count < options.blockSize && (more = static_cast<bool>(std::getline(in, line))))
+        {
+            std::string_view rest(line);
+            std::string_view first = nextToken(rest);
+            if (first.empty() || first[0] == '#') continue;
+            Query& q = block[count++];
+            q.src = airports.find(first);
+            q.dst = airports.find(nextToken(rest));
+            q.result.path.clear();
+            q.result.distance = q.result.direct = -1.0;
+            q.result.flags = q.src < 0 || q.dst < 0 ? std::uint32_t(ResultInvalid) : 0u;
+            if (q.result.flags) q.text = line;
+        }
+        if (count == 0) break;
+
+        pool.run(count, [&](int i, unsigned worker) {
+            Query& q = block[i];
+            if (q.result.flags & ResultInvalid) return;
+            answerRoute(weatherView, q.src, q.dst, options.mode, q.result, directPaths[worker], pathEdges[worker],
+                        options.useHierarchy ? &directHierarchy : nullptr,
+                        options.useHierarchy ? &weatherHierarchy : nullptr);
+        });
+
+        buffer.clear();
+        for (int i = 0; i < count; ++i)
+        {
+            const Query& q = block[i];
+            const RouteResult& r = q.result;
+            ++st.queries;
+            st.invalid += (r.flags & ResultInvalid) != 0;
+            st.found += (r.flags & ResultFound) != 0;
+            st.rerouted += (r.flags & ResultRerouted) != 0;
+
+            if (options.format == BatchFormat::Binary)
+            {
+                RouteResultHeader header = {q.src, q.dst, r.flags, static_cast<std::uint32_t>(r.path.size()),
+                                            r.distance, r.direct};
+                buffer.append(reinterpret_cast<const char*>(&header), sizeof header);
+                buffer.append(reinterpret_cast<const char*>(r.path.data()), r.path.size() * sizeof(int));
+                continue;
+            }
+
+            if (r.flags & ResultInvalid)
+            {
+                std::string_view rest(q.text);
+                buffer += "{\"src\":";
+                appendJsonString(buffer, nextToken(rest));
+                buffer += ",\"dst\":";
+                appendJsonString(buffer, nextToken(rest));
+                buffer += ",\"error\":\"unknown airport\"}\n";
+                continue;
+            }
+            appendRouteJson(buffer, graph, q.src, q.dst, r);
+        }
+        out.write(buffer.data(), buffer.size());
+    }
+
+    out.flush();
+    st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<bool>(out);
+}
+
+// Reads the queries of in (the format above) for the batch modes that
+// answer them all at once, such as weather_scenarios.hpp's, into endpoints.
+// Lines with an unknown airport are skipped and noted in log.
+inline void readBatchEndpoints(std::istream& in, const FlightGraph& graph,
+                               std::vector<std::pair<int, int>>& endpoints, std::ostream& log)
+{
+    AirportLookup airports(graph);
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number)
+    {
+        std::string_view rest(line);
+        std::string_view first = nextToken(rest);
+        if (first.empty() || first[0] == '#') continue;
+        int src = airports.find(first), dst = airports.find(nextToken(rest));
+        if (src < 0 || dst < 0)
+        {
+            log << "Skipping line " << number << ": unknown airport" << std::endl;
+            continue;
+        }
+        endpoints.push_back({src, dst});
+    }
+}
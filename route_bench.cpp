@@ -0,0 +1,1440 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include "flight_graph.hpp"
+#include "route_matrix.hpp"
+#include "network_loader.hpp"
+#include "graph_snapshot.hpp"
+#include "spatial_index.hpp"
+#include "weather_feed.hpp"
+#include "weather_epochs.hpp"
+#include "route_service.hpp"
+#include "map_quadtree.hpp"
+#include "fleet_simulation.hpp"
+#include "fleet_events.hpp"
+#include "weather_scenarios.hpp"
+#include "timetable.hpp"
+#include "pareto_routes.hpp"
+#include "forecast_routing.hpp"
+#include <atomic>
+#include <sstream>
+
+void printLine(char c = '-', int length = 50)
+{
+    for (int i = 0; i < length; i++)
+    {
+        std::cout << c;
+    }
+    std::cout << std::endl;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Random airports on a 900x650 map, each linked to its k nearest
+// neighbours.
+FlightGraph buildSyntheticNetwork(int n, int k, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> xs(0.0f, 900.0f), ys(0.0f, 650.0f);
+
+    FlightGraph graph;
+    graph.airports.reserve(n);
+    for (int i = 0; i < n; ++i)
+        graph.addAirport("A" + std::to_string(i), xs(rng), ys(rng));
+
+    KdTree tree;
+    tree.build(graph.airports);
+    WorkStealingPool pool;
+    connectNearest(graph, tree, k, pool);
+    return graph;
+}
+
+void benchRouteMatrix(int airports, int sourceCount, int targetCount, unsigned maxThreads)
+{
+    printLine('=');
+    std::cout << "ROUTE MATRIX SCALING" << std::endl;
+    printLine('=');
+
+    auto start = std::chrono::steady_clock::now();
+    FlightGraph graph = buildSyntheticNetwork(airports, 6, 42);
+    std::cout << "Network: " << graph.airportCount() << " airports, " << graph.edgeCount()
+              << " edges (built in " << std::fixed << std::setprecision(1) << secondsSince(start) * 1000 << " ms)" << std::endl;
+
+    std::mt19937 rng(7);
+    std::vector<int> sources(sourceCount), targets(targetCount);
+    for (int& s : sources) s = static_cast<int>(rng() % airports);
+    for (int& t : targets) t = static_cast<int>(rng() % airports);
+    std::cout << "Matrix: " << sourceCount << " x " << targetCount << std::endl;
+    printLine();
+
+    GraphView view(graph);
+    std::vector<unsigned> threadCounts;
+    for (unsigned t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    std::cout << std::left << std::setw(10) << "Threads" << std::setw(14) << "Time (ms)"
+              << std::setw(12) << "Speedup" << std::setw(12) << "Efficiency" << std::endl;
+
+    double baseline = 0.0;
+    RouteMatrix reference;
+    for (unsigned threads : threadCounts)
+    {
+        WorkStealingPool pool(threads);
+        start = std::chrono::steady_clock::now();
+        RouteMatrix matrix = computeRouteMatrix(view, sources, targets, pool);
+        double elapsed = secondsSince(start);
+
+        if (threads == 1)
+        {
+            baseline = elapsed;
+            reference = matrix;
+        }
+        else if (matrix.distance != reference.distance)
+        {
+            std::cout << "ERROR: matrix computed with " << threads << " threads differs from 1 thread" << std::endl;
+        }
+
+        double speedup = baseline / elapsed;
+        std::cout << std::left << std::setw(10) << threads
+                  << std::setw(14) << std::setprecision(1) << elapsed * 1000
+                  << std::setw(12) << std::setprecision(2) << speedup
+                  << std::setw(12) << speedup / threads << std::endl;
+    }
+    printLine();
+}
+
+template <typename Queue>
+double timeQueries(const GraphView& view, const std::vector<std::pair<int, int>>& queries, SearchMode mode,
+                   std::vector<double>& distances, long long& settled)
+{
+    std::vector<int> path;
+    SearchStats stats;
+    distances.clear();
+    settled = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto [src, dst] : queries)
+    {
+        view.shortestPath<Queue>(src, dst, path, mode, &stats);
+        distances.push_back(stats.distance);
+        settled += stats.settled;
+    }
+    return secondsSince(start);
+}
+
+void benchQueuesOn(const std::string& name, const FlightGraph& graph, int queryCount)
+{
+    std::mt19937 rng(11);
+    std::vector<std::pair<int, int>> queries(queryCount);
+    for (auto& q : queries)
+        q = {static_cast<int>(rng() % graph.airportCount()), static_cast<int>(rng() % graph.airportCount())};
+
+    std::cout << name << ": " << graph.airportCount() << " airports, " << graph.edgeCount() << " edges, "
+              << queryCount << " queries" << std::endl;
+    std::cout << std::left << std::setw(12) << "Mode" << std::setw(10) << "Queue"
+              << std::setw(16) << "us/query" << std::setw(12) << "Settled" << std::endl;
+
+    GraphView view(graph);
+    const char* modeNames[] = {"dijkstra", "astar", "bidir", "bidir-astar"};
+    const char* queueNames[] = {"lazy", "4ary", "radix"};
+    for (int m = 0; m < 4; ++m)
+    {
+        SearchMode mode = static_cast<SearchMode>(m);
+        std::vector<double> reference, distances;
+        for (int q = 0; q < 3; ++q)
+        {
+            long long settled = 0;
+            double elapsed = 0.0;
+            switch (static_cast<QueueKind>(q))
+            {
+                case QueueKind::Lazy: elapsed = timeQueries<LazyHeap>(view, queries, mode, distances, settled); break;
+                case QueueKind::Quaternary: elapsed = timeQueries<QuaternaryHeap>(view, queries, mode, distances, settled); break;
+                case QueueKind::Radix: elapsed = timeQueries<RadixHeap>(view, queries, mode, distances, settled); break;
+            }
+            if (q == 0) reference = distances;
+            for (size_t i = 0; i < distances.size(); ++i)
+            {
+                if (std::fabs(distances[i] - reference[i]) > 1e-6 * std::max(1.0, reference[i]))
+                {
+                    std::cout << "ERROR: " << queueNames[q] << " disagrees with lazy heap on query " << i << std::endl;
+                    break;
+                }
+            }
+            std::cout << std::left << std::setw(12) << modeNames[m] << std::setw(10) << queueNames[q]
+                      << std::setw(16) << std::fixed << std::setprecision(2) << elapsed * 1e6 / queryCount
+                      << std::setw(12) << settled / queryCount << std::endl;
+        }
+    }
+    printLine();
+}
+
+void benchQueues(int queryCount)
+{
+    printLine('=');
+    std::cout << "PRIORITY QUEUE BACKENDS" << std::endl;
+    printLine('=');
+
+    benchQueuesOn("Stock network", makeDefaultNetwork(), queryCount * 10);
+    benchQueuesOn("Synthetic 20k", buildSyntheticNetwork(20000, 6, 42), queryCount);
+    benchQueuesOn("Synthetic 200k", buildSyntheticNetwork(200000, 6, 43), std::max(1, queryCount / 4));
+}
+
+void benchLoad(const std::string& airportsPath, const std::string& routesPath)
+{
+    printLine('=');
+    std::cout << "CSV NETWORK LOAD" << std::endl;
+    printLine('=');
+
+    FlightGraph graph;
+    CsvLoadStats stats;
+    if (!loadNetworkCsv(airportsPath, routesPath, graph, &stats))
+    {
+        std::cout << "ERROR: could not read " << airportsPath << " or " << routesPath << std::endl;
+        return;
+    }
+    std::cout << "Airports: " << stats.airports << ", routes: " << stats.routes << ", skipped rows: " << stats.skipped << std::endl;
+    std::cout << "Network: " << graph.airportCount() << " airports, " << graph.edgeCount() << " edges" << std::endl;
+    std::cout << "Read " << std::fixed << std::setprecision(2) << stats.bytes / (1024.0 * 1024.0) << " MB in "
+              << std::setprecision(1) << stats.seconds * 1000 << " ms (" << stats.megabytesPerSecond() << " MB/s)" << std::endl;
+    printLine();
+}
+
+void benchSnapshot(int airports, const std::string& path)
+{
+    printLine('=');
+    std::cout << "GRAPH SNAPSHOT" << std::endl;
+    printLine('=');
+
+    auto start = std::chrono::steady_clock::now();
+    FlightGraph graph = buildSyntheticNetwork(airports, 6, 42);
+    double buildSeconds = secondsSince(start);
+    graph.updateWeather(graph.edgeFrom[0], graph.edgeTo[0], true, "Storm");
+
+    start = std::chrono::steady_clock::now();
+    if (!saveGraphSnapshot(graph, path))
+    {
+        std::cout << "ERROR: could not write " << path << std::endl;
+        return;
+    }
+    double saveSeconds = secondsSince(start);
+
+    FlightGraph loaded;
+    start = std::chrono::steady_clock::now();
+    if (!loadGraphSnapshot(path, loaded))
+    {
+        std::cout << "ERROR: could not load " << path << std::endl;
+        return;
+    }
+    double loadSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    SearchStats stats;
+    std::vector<int> path0 = loaded.shortestPath(0, airports - 1, SearchMode::Dijkstra, &stats);
+    double firstQuerySeconds = secondsSince(start);
+
+    bool same = loaded.airportCount() == graph.airportCount() && loaded.edgeCount() == graph.edgeCount() &&
+                std::equal(graph.arcTarget.begin(), graph.arcTarget.end(), loaded.arcTarget.begin()) &&
+                std::equal(graph.arcWeight.begin(), graph.arcWeight.end(), loaded.arcWeight.begin()) &&
+                loaded.isEdgeBad(graph.edgeFrom[0], graph.edgeTo[0]) && path0 == graph.shortestPath(0, airports - 1);
+    if (!same) std::cout << "ERROR: loaded snapshot differs from the original graph" << std::endl;
+
+    std::cout << "Network: " << graph.airportCount() << " airports, " << graph.edgeCount() << " edges" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Build from scratch: " << buildSeconds * 1000 << " ms" << std::endl;
+    std::cout << "Save snapshot:      " << saveSeconds * 1000 << " ms" << std::endl;
+    std::cout << "Load snapshot:      " << loadSeconds * 1000 << " ms" << std::endl;
+    std::cout << "First query:        " << firstQuerySeconds * 1000 << " ms (settled " << stats.settled << ")" << std::endl;
+    printLine();
+}
+
+void benchSpatial(int airports, int k, unsigned maxThreads)
+{
+    printLine('=');
+    std::cout << "SPATIAL INDEX" << std::endl;
+    printLine('=');
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> xs(0.0f, 900.0f), ys(0.0f, 650.0f);
+    FlightGraph points;
+    for (int i = 0; i < airports; ++i)
+        points.addAirport("A" + std::to_string(i), xs(rng), ys(rng));
+
+    auto start = std::chrono::steady_clock::now();
+    KdTree tree;
+    tree.build(points.airports);
+    std::cout << "k-d tree over " << airports << " airports built in " << std::fixed << std::setprecision(1)
+              << secondsSince(start) * 1000 << " ms" << std::endl;
+
+    // Near-point queries, checked against a linear scan on a sample.
+    const int queries = 100000;
+    std::vector<std::pair<float, float>> probes(queries);
+    for (auto& p : probes) p = {xs(rng), ys(rng)};
+    start = std::chrono::steady_clock::now();
+    long long checksum = 0;
+    for (auto [x, y] : probes) checksum += tree.nearest(x, y);
+    double nearestSeconds = secondsSince(start);
+    for (int q = 0; q < 200; ++q)
+    {
+        auto [x, y] = probes[q];
+        int found = tree.nearest(x, y);
+        float best = std::numeric_limits<float>::infinity();
+        for (const Airport& a : points.airports)
+        {
+            float dx = a.position.x - x, dy = a.position.y - y;
+            best = std::min(best, dx * dx + dy * dy);
+        }
+        float dx = points.airports[found].position.x - x, dy = points.airports[found].position.y - y;
+        if (dx * dx + dy * dy > best)
+        {
+            std::cout << "ERROR: nearest airport query " << q << " is not the closest" << std::endl;
+            break;
+        }
+    }
+    std::cout << "Nearest airport: " << std::setprecision(2) << nearestSeconds * 1e6 / queries << " us/query" << std::endl;
+    printLine();
+
+    std::cout << std::left << std::setw(10) << "Threads" << std::setw(18) << "kNN build (ms)"
+              << std::setw(20) << "Radius build (ms)" << std::setw(12) << "Edges" << std::endl;
+    float radius = std::sqrt(k * 900.0f * 650.0f / (3.14159f * airports));
+    std::vector<unsigned> threadCounts;
+    for (unsigned t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+    for (unsigned threads : threadCounts)
+    {
+        WorkStealingPool pool(threads);
+        FlightGraph nearestGraph = points;
+        start = std::chrono::steady_clock::now();
+        connectNearest(nearestGraph, tree, k, pool);
+        double nearestBuild = secondsSince(start);
+
+        FlightGraph radiusGraph = points;
+        start = std::chrono::steady_clock::now();
+        connectWithinRadius(radiusGraph, tree, radius, pool);
+        double radiusBuild = secondsSince(start);
+
+        std::cout << std::left << std::setw(10) << threads << std::setprecision(1)
+                  << std::setw(18) << nearestBuild * 1000 << std::setw(20) << radiusBuild * 1000
+                  << nearestGraph.edgeCount() << " / " << radiusGraph.edgeCount() << std::endl;
+    }
+    std::cout << "(radius " << std::setprecision(2) << radius << ", about " << k << " airports per disc; checksum "
+              << checksum << ")" << std::endl;
+    printLine();
+}
+
+// View culling as the map renderer does it: airport markers and edge
+// extents in quadtrees, queried with views at increasing zoom.
+void benchCull(int airports, int viewCount)
+{
+    printLine('=');
+    std::cout << "VIEW CULLING" << std::endl;
+    printLine('=');
+
+    FlightGraph graph = buildSyntheticNetwork(airports, 6, 42);
+    std::vector<MapRect> airportBoxes, edgeBoxes;
+    for (const Airport& a : graph.airports)
+        airportBoxes.push_back({a.position.x, a.position.y, a.position.x + 40.0f, a.position.y + 16.0f});
+    for (int e = 0; e < graph.edgeCount(); ++e)
+    {
+        const MapPoint& a = graph.airports[graph.edgeFrom[e]].position;
+        const MapPoint& b = graph.airports[graph.edgeTo[e]].position;
+        edgeBoxes.push_back({std::min(a.x, b.x), std::min(a.y, b.y), std::max(a.x, b.x), std::max(a.y, b.y)});
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    MapQuadtree airportTree, edgeTree;
+    airportTree.build(airportBoxes);
+    edgeTree.build(edgeBoxes);
+    std::cout << airports << " airports and " << graph.edgeCount() << " edges indexed in " << std::fixed
+              << std::setprecision(1) << secondsSince(start) * 1000 << " ms" << std::endl;
+    printLine();
+
+    std::cout << std::left << std::setw(8) << "Zoom" << std::setw(14) << "Airports" << std::setw(14) << "Edges"
+              << std::setw(10) << "Ranges" << std::setw(14) << "Query (us)" << "Scan (us)" << std::endl;
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> xs(0.0f, 900.0f), ys(0.0f, 650.0f);
+    std::vector<std::pair<int, int>> runs;
+    for (float zoom = 1.0f; zoom <= 256.0f; zoom *= 4.0f)
+    {
+        float w = 900.0f / zoom, h = 650.0f / zoom;
+        std::vector<MapRect> views(viewCount);
+        for (MapRect& v : views)
+        {
+            float x = xs(rng), y = ys(rng);
+            v = {x - 0.5f * w, y - 0.5f * h, x + 0.5f * w, y + 0.5f * h};
+        }
+
+        long long visibleAirports = 0, visibleEdges = 0, ranges = 0;
+        start = std::chrono::steady_clock::now();
+        for (const MapRect& v : views)
+        {
+            visibleAirports += airportTree.query(v, runs);
+            ranges += runs.size();
+            visibleEdges += edgeTree.query(v, runs);
+            ranges += runs.size();
+        }
+        double querySeconds = secondsSince(start);
+
+        // What drawing everything and letting the GPU clip used to cost in
+        // per-item work, for comparison.
+        long long scanned = 0;
+        start = std::chrono::steady_clock::now();
+        for (const MapRect& v : views)
+        {
+            for (const MapRect& box : airportBoxes) scanned += box.intersects(v);
+            for (const MapRect& box : edgeBoxes) scanned += box.intersects(v);
+        }
+        double scanSeconds = secondsSince(start);
+        if (scanned != visibleAirports + visibleEdges)
+            std::cout << "ERROR: culling found " << visibleAirports + visibleEdges << " items, a scan " << scanned << std::endl;
+
+        std::cout << std::left << std::setw(8) << zoom << std::setprecision(1)
+                  << std::setw(14) << double(visibleAirports) / viewCount << std::setw(14) << double(visibleEdges) / viewCount
+                  << std::setw(10) << double(ranges) / viewCount << std::setprecision(2)
+                  << std::setw(14) << querySeconds * 1e6 / viewCount << scanSeconds * 1e6 / viewCount << std::endl;
+    }
+    printLine();
+}
+
+// Fleet animation steps at 60 Hz: the SoA kinematics against finding each
+// aircraft's segment by scanning its route's lengths from the start, as
+// the single animated flight used to.
+void benchFleet(int aircraft, int routes, int steps)
+{
+    printLine('=');
+    std::cout << "FLEET KINEMATICS" << std::endl;
+    printLine('=');
+
+    FlightGraph graph = buildSyntheticNetwork(20000, 6, 42);
+    auto start = std::chrono::steady_clock::now();
+    FleetKinematics fleet;
+    routes = addRandomFlights(fleet, graph, routes, 40.0f, 120.0f, 11);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> fraction(0.0f, 1.0f);
+    for (int a = routes; a < aircraft; ++a)
+    {
+        int r = a % routes;
+        fleet.addAircraft(r, 40.0f + 80.0f * fraction(rng), fraction(rng) * fleet.routeLength(r));
+    }
+    int segments = static_cast<int>(fleet.pointX.size()) - routes;
+    std::cout << fleet.size() << " aircraft on " << routes << " routes (" << std::fixed << std::setprecision(1)
+              << double(segments) / routes << " legs each) set up in " << secondsSince(start) * 1000 << " ms"
+              << std::endl;
+
+    std::vector<float> progress(fleet.size()), scanX(fleet.size()), scanY(fleet.size());
+    for (int a = 0; a < fleet.size(); ++a) progress[a] = fleet.distance[a];
+    const float dt = 1.0f / 60;
+    start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s)
+    {
+        for (int a = 0; a < fleet.size(); ++a)
+        {
+            int r = fleet.route[a], first = fleet.routeFirst[r], last = fleet.routeFirst[r + 1] - 1;
+            progress[a] = std::fmod(progress[a] + fleet.speed[a] * dt, fleet.routeLength(r));
+            int c = first;
+            while (c + 1 < last && progress[a] >= fleet.pointArc[c + 1]) ++c;
+            float t = progress[a] - fleet.pointArc[c];
+            scanX[a] = fleet.pointX[c] + fleet.segmentDirX[c] * t;
+            scanY[a] = fleet.pointY[c] + fleet.segmentDirY[c] * t;
+        }
+    }
+    double scanSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s) fleet.advance(dt);
+    double soaSeconds = secondsSince(start);
+
+    float worst = 0.0f;
+    for (int a = 0; a < fleet.size(); ++a)
+        worst = std::max(worst, std::max(std::fabs(scanX[a] - fleet.x[a]), std::fabs(scanY[a] - fleet.y[a])));
+
+    printLine();
+    double updates = double(fleet.size()) * steps;
+    std::cout << std::left << std::setw(22) << "Segment scan" << std::setprecision(2) << scanSeconds * 1e9 / updates
+              << " ns/aircraft, " << std::setprecision(0) << updates / scanSeconds / 1e6 << "M updates/s" << std::endl;
+    std::cout << std::left << std::setw(22) << "SoA with cursors" << std::setprecision(2) << soaSeconds * 1e9 / updates
+              << " ns/aircraft, " << std::setprecision(0) << updates / soaSeconds / 1e6 << "M updates/s" << std::endl;
+    std::cout << std::setprecision(1) << "Speedup " << scanSeconds / soaSeconds << "x; one 60 Hz step for the fleet takes "
+              << std::setprecision(3) << soaSeconds * 1000 / steps << " ms (largest position difference "
+              << std::setprecision(4) << worst << ")" << std::endl;
+    printLine();
+}
+
+// The simulation thread against a consumer that takes snapshots as fast as
+// it can: first a triple buffer handing over large payloads, every one
+// checked for torn or out-of-order contents, then the fleet simulation
+// itself, unpaced.
+void benchSimulation(int aircraft, double seconds)
+{
+    printLine('=');
+    std::cout << "SIMULATION THREAD" << std::endl;
+    printLine('=');
+
+    struct Payload
+    {
+        std::uint64_t step = 0;
+        std::vector<std::uint64_t> values;
+    };
+    TripleBuffer<Payload> buffer;
+    std::atomic<bool> producing{true};
+    std::uint64_t produced = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([&] {
+        while (producing.load())
+        {
+            Payload& p = buffer.writeBuffer();
+            p.step = ++produced;
+            p.values.assign(4096, produced);
+            buffer.publish();
+        }
+    });
+    long long consumed = 0, torn = 0, backwards = 0;
+    std::uint64_t lastStep = 0;
+    while (secondsSince(start) < seconds / 2)
+    {
+        if (!buffer.acquire())
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const Payload& p = buffer.readBuffer();
+        ++consumed;
+        backwards += p.step <= lastStep;
+        lastStep = p.step;
+        for (std::uint64_t v : p.values) torn += v != p.step;
+    }
+    producing = false;
+    producer.join();
+    std::cout << "Triple buffer: " << produced << " published, " << consumed << " consumed, " << torn
+              << " torn values, " << backwards << " out of order" << std::endl;
+    if (torn || backwards) std::cout << "ERROR: the triple buffer handed over inconsistent snapshots" << std::endl;
+
+    FlightGraph graph = buildSyntheticNetwork(20000, 6, 42);
+    FleetKinematics fleet;
+    int routes = addRandomFlights(fleet, graph, std::min(aircraft, 500), 40.0f, 120.0f, 11);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> fraction(0.0f, 1.0f);
+    for (int a = routes; a < aircraft; ++a)
+        fleet.addAircraft(a % routes, 40.0f + 80.0f * fraction(rng), fraction(rng) * fleet.routeLength(a % routes));
+
+    SimulationOptions options;
+    options.timeScale = 0.0;
+    FleetSimulation simulator(fleet, options);
+    start = std::chrono::steady_clock::now();
+    simulator.start();
+    long long frames = 0;
+    double jumps = 0.0;
+    while (secondsSince(start) < seconds / 2)
+    {
+        if (!simulator.acquire())
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const FleetSnapshot& s = simulator.snapshot();
+        ++frames;
+        // A consistent snapshot moves no aircraft further than one step.
+        for (int a = 0; a < s.size(); ++a)
+            jumps = std::max(jumps, double(std::hypot(s.x[a] - s.previousX[a], s.y[a] - s.previousY[a])));
+    }
+    simulator.stop();
+    double elapsed = secondsSince(start);
+    double steps = static_cast<double>(simulator.steps());
+    printLine();
+    std::cout << fleet.size() << " aircraft, unpaced at " << std::fixed << std::setprecision(4) << options.timestep
+              << " s per step:" << std::endl;
+    std::cout << std::setprecision(0) << steps / elapsed << " steps/s (" << steps * options.timestep / elapsed
+              << "x real time), " << frames / elapsed << " snapshots/s consumed" << std::endl;
+    std::cout << "Largest move within one step: " << std::setprecision(2) << jumps << " map units (at most "
+              << 120.0 * options.timestep << " expected)" << std::endl;
+    printLine();
+}
+
+// The event queue alone in the classic hold model (pop the earliest
+// event, push one a random time later, so the size stays put), calendar
+// queue against a binary heap, then the discrete-event fleet simulation
+// with random weather every half hour.
+void benchEvents(int airports, int aircraft, double hours)
+{
+    printLine('=');
+    std::cout << "DISCRETE-EVENT FLEET" << std::endl;
+    printLine('=');
+
+    const int holds = 2000000;
+    std::cout << "Hold model, " << holds << " pop+push pairs:" << std::endl;
+    for (int size : {1000, 100000, 1000000})
+    {
+        std::mt19937 rng(5);
+        std::exponential_distribution<double> gap(1.0);
+        std::vector<double> delays(holds);
+        for (double& d : delays) d = gap(rng);
+
+        double now = 0.0, checksum = 0.0;
+        CalendarQueue<int> calendar;
+        for (int k = 0; k < size; ++k) calendar.push(gap(rng) * size / 1000.0, k);
+        auto start = std::chrono::steady_clock::now();
+        for (int k = 0; k < holds; ++k)
+        {
+            int v = calendar.pop(now);
+            checksum += now;
+            calendar.push(now + delays[k] * size / 1000.0, v);
+        }
+        double calendarSeconds = secondsSince(start);
+
+        using Timed = std::pair<double, int>;
+        std::priority_queue<Timed, std::vector<Timed>, std::greater<Timed>> heap;
+        rng.seed(5);
+        for (double& d : delays) d = gap(rng);
+        for (int k = 0; k < size; ++k) heap.push({gap(rng) * size / 1000.0, k});
+        double heapChecksum = 0.0;
+        start = std::chrono::steady_clock::now();
+        for (int k = 0; k < holds; ++k)
+        {
+            Timed e = heap.top();
+            heap.pop();
+            heapChecksum += e.first;
+            heap.push({e.first + delays[k] * size / 1000.0, e.second});
+        }
+        double heapSeconds = secondsSince(start);
+
+        std::cout << "  " << std::left << std::setw(9) << size << "pending: calendar " << std::fixed
+                  << std::setprecision(1) << calendarSeconds * 1e9 / holds << " ns, binary heap "
+                  << heapSeconds * 1e9 / holds << " ns" << (checksum == heapChecksum ? "" : " (ORDER DIFFERS)")
+                  << std::endl;
+    }
+
+    FlightGraph graph = buildSyntheticNetwork(airports, 6, 42);
+    FleetEventOptions options;
+    options.aircraft = aircraft;
+    options.hours = hours;
+    FleetEventSimulation simulation(graph, options, randomWeather(graph.edgeCount() / 50, 0.5, 9));
+    FleetEventStats stats;
+    simulation.run(stats);
+
+    printLine();
+    std::cout << aircraft << " aircraft on " << airports << " airports, " << std::setprecision(0)
+              << stats.simulatedHours << " simulated hours in " << std::setprecision(2) << stats.seconds << " s ("
+              << std::setprecision(0) << stats.simulatedHours * 3600 / stats.seconds << "x real time)" << std::endl;
+    std::cout << stats.events << " events: " << stats.departures << " departures, " << stats.legs << " legs, "
+              << stats.landings << " landings, " << stats.weatherEpochs << " weather epochs" << std::endl;
+    std::cout << stats.edgesClosed << " edges closed, " << stats.reroutes << " en-route reroutes, " << stats.grounded
+              << " held on the ground, " << stats.searches << " route searches" << std::endl;
+    std::cout << "Throughput: " << stats.eventsPerSecond() << " events/s; routing took " << std::setprecision(2)
+              << stats.searchSeconds << " s (" << std::setprecision(1) << stats.searchSeconds * 1e6 / stats.searches
+              << " us per search), the rest ran at " << std::setprecision(0)
+              << stats.events / (stats.seconds - stats.searchSeconds) << " events/s" << std::endl;
+    printLine();
+}
+
+// Monte Carlo route reliability with 1, 2, 4, ... threads; every thread
+// count must give exactly the single-thread results. Setting up a
+// scenario's overlay is then timed against copying the graph and applying
+// the failures to it as weather.
+void benchScenarios(int airports, int pairCount, int scenarios, unsigned maxThreads)
+{
+    printLine('=');
+    std::cout << "WEATHER SCENARIOS" << std::endl;
+    printLine('=');
+
+    FlightGraph graph = buildSyntheticNetwork(airports, 6, 42);
+    FailureModel model(graph, 0.01);
+    std::mt19937 rng(7);
+    std::vector<PairReliability> pairs(pairCount);
+    for (PairReliability& pair : pairs)
+    {
+        pair.src = static_cast<int>(rng() % airports);
+        pair.dst = static_cast<int>(rng() % airports);
+    }
+    std::cout << graph.edgeCount() << " legs failing with probability 0.01, " << pairCount << " routes, "
+              << scenarios << " scenarios" << std::endl;
+    printLine();
+
+    std::vector<unsigned> threadCounts;
+    for (unsigned t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+    std::cout << std::left << std::setw(10) << "Threads" << std::setw(14) << "Time (ms)" << std::setw(16)
+              << "Scenarios/s" << std::setw(12) << "Speedup" << std::endl;
+
+    ScenarioOptions options;
+    options.scenarios = scenarios;
+    ScenarioStats stats;
+    std::vector<PairReliability> reference;
+    double baseline = 0.0;
+    for (unsigned threads : threadCounts)
+    {
+        options.threads = threads;
+        analyseWeatherScenarios(graph, model, pairs, options, &stats);
+        if (threads == 1)
+        {
+            baseline = stats.seconds;
+            reference = pairs;
+        }
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            if (pairs[i].blocked != reference[i].blocked || pairs[i].unreachable != reference[i].unreachable ||
+                pairs[i].detours != reference[i].detours)
+            {
+                std::cout << "ERROR: results with " << threads << " threads differ from 1 thread" << std::endl;
+                break;
+            }
+        }
+        std::cout << std::left << std::setw(10) << threads << std::setw(14) << std::fixed << std::setprecision(1)
+                  << stats.seconds * 1000 << std::setw(16) << std::setprecision(0) << stats.scenariosPerSecond()
+                  << std::setw(12) << std::setprecision(2) << baseline / stats.seconds << std::endl;
+    }
+
+    double blocked = 0.0, rerouted = 0.0, unreachable = 0.0, worst = 0.0;
+    for (const PairReliability& pair : pairs)
+    {
+        blocked += pair.rate(pair.blocked);
+        rerouted += pair.rate(pair.rerouted);
+        unreachable += pair.rate(pair.unreachable);
+        worst = std::max(worst, pair.detourQuantile(0.99));
+    }
+    printLine();
+    std::cout << "Mean over routes: blocked " << std::setprecision(3) << blocked / pairCount << ", rerouted "
+              << rerouted / pairCount << ", no path " << unreachable / pairCount << "; worst p99 detour "
+              << std::setprecision(1) << worst << std::endl;
+    std::cout << "Per scenario: " << std::setprecision(1) << double(stats.failedEdges) / scenarios << " failed legs, "
+              << double(stats.searches) / scenarios << " reroute searches" << std::endl;
+
+    std::vector<std::uint64_t> available(graph.availableBits.begin(), graph.availableBits.end());
+    std::vector<int> failed;
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < scenarios; ++s)
+    {
+        for (int e : failed) available[e >> 6] = graph.availableBits[e >> 6];
+        failed.clear();
+        ScenarioRandom random(options.seed, s);
+        model.sample(random, failed);
+        for (int e : failed) available[e >> 6] &= ~(std::uint64_t(1) << (e & 63));
+    }
+    double overlaySeconds = secondsSince(start) / scenarios;
+
+    start = std::chrono::steady_clock::now();
+    FlightGraph copy = graph;
+    std::vector<WeatherUpdate> updates;
+    std::uint32_t description = copy.internDescription("Thunderstorm");
+    for (int e : failed) updates.push_back({e, true, description});
+    copy.applyWeatherUpdates(updates);
+    double copySeconds = secondsSince(start);
+    std::cout << "Scenario setup: " << std::setprecision(1) << overlaySeconds * 1e6 << " us to sample and overlay, "
+              << copySeconds * 1e6 << " us to copy the graph and apply it as weather" << std::endl;
+    printLine();
+}
+
+// Connection Scan on a three-day synthetic schedule: earliest-arrival
+// queries at random times, then full-day profile queries, each of whose
+// options must match an earliest-arrival query leaving at that time.
+void benchTimetable(int airports, int flightsPerLeg, int queryCount)
+{
+    printLine('=');
+    std::cout << "TIMETABLE (CONNECTION SCAN)" << std::endl;
+    printLine('=');
+
+    FlightGraph graph = buildSyntheticNetwork(airports, 6, 42);
+    ScheduleOptions schedule;
+    schedule.flightsPerLeg = flightsPerLeg;
+    schedule.days = 3;
+    auto start = std::chrono::steady_clock::now();
+    Timetable timetable = buildTimetable(graph, schedule);
+    std::cout << timetable.size() << " connections over " << schedule.days << " days ("
+              << timetable.size() * sizeof(Connection) / (1024 * 1024) << " MB), built and sorted in " << std::fixed
+              << std::setprecision(1) << secondsSince(start) * 1000 << " ms" << std::endl;
+    printLine();
+
+    std::mt19937 rng(7);
+    std::vector<std::array<int, 3>> queries(queryCount);
+    for (auto& q : queries) q = {static_cast<int>(rng() % airports), static_cast<int>(rng() % airports),
+                                 static_cast<int>(rng() % 1440)};
+
+    ScanStats scan;
+    long long scanned = 0;
+    int reached = 0;
+    double earliestSeconds = 0.0;
+    for (const auto& q : queries)
+    {
+        reached += timetable.earliestArrival(q[0], q[1], q[2], nullptr, &scan) >= 0;
+        scanned += scan.scanned;
+        earliestSeconds += scan.seconds;
+    }
+    std::cout << "Earliest arrival: " << std::setprecision(3) << earliestSeconds * 1000 / queryCount << " ms/query, "
+              << std::setprecision(0) << double(scanned) / queryCount << " connections scanned, " << reached << "/"
+              << queryCount << " reachable" << std::endl;
+
+    std::vector<ProfileEntry> options;
+    long long optionCount = 0, mismatches = 0;
+    double profileSeconds = 0.0;
+    int profileQueries = std::max(1, queryCount / 10);
+    for (int i = 0; i < profileQueries; ++i)
+    {
+        const auto& q = queries[i];
+        timetable.profile(q[0], q[1], 0, 1439, options, &scan);
+        profileSeconds += scan.seconds;
+        optionCount += options.size();
+        for (const ProfileEntry& option : options)
+            mismatches += timetable.earliestArrival(q[0], q[1], option.departure) != option.arrival;
+    }
+    std::cout << "Profile over a day: " << std::setprecision(3) << profileSeconds * 1000 / profileQueries
+              << " ms/query, " << std::setprecision(1) << double(optionCount) / profileQueries
+              << " Pareto-optimal departures per pair" << std::endl;
+    if (mismatches)
+        std::cout << "ERROR: " << mismatches << " profile options disagree with earliest-arrival queries" << std::endl;
+    printLine();
+}
+
+// Mean labels, Pareto routes, largest per-airport set and time over
+// queries on one network; the query pairs are fixed by seed.
+struct ParetoRun
+{
+    double labels = 0.0;
+    double routes = 0.0;
+    int largestSet = 0;
+    int truncated = 0;
+    size_t poolBytes = 0;
+    double seconds = 0.0;
+};
+
+ParetoRun runPareto(const FlightGraph& graph, const RouteCriteria& criteria, const ParetoOptions& options,
+                    int queryCount)
+{
+    ParetoSearch search(graph, criteria, options);
+    GraphView view(graph);
+    std::vector<ParetoRoute> routes;
+    ParetoStats stats;
+    ParetoRun run;
+    std::mt19937 rng(7);
+    for (int q = 0; q < queryCount; ++q)
+    {
+        int src = static_cast<int>(rng() % graph.airportCount()), dst = static_cast<int>(rng() % graph.airportCount());
+        search.search(view, src, dst, routes, &stats);
+        run.labels += double(stats.created) / queryCount;
+        run.routes += double(routes.size()) / queryCount;
+        run.largestSet = std::max(run.largestSet, stats.largestSet);
+        run.truncated += stats.truncated;
+        run.poolBytes = std::max(run.poolBytes, stats.poolBytes);
+        run.seconds += stats.seconds / queryCount;
+    }
+    return run;
+}
+
+void benchPareto(int maxAirports, int queryCount)
+{
+    printLine('=');
+    std::cout << "PARETO ROUTES (DISTANCE, RISK, FARE)" << std::endl;
+    printLine('=');
+    std::cout << "Legs fail with probability 0.2% to 3.2%; " << queryCount << " random queries per network" << std::endl;
+    printLine();
+
+    auto network = [](int airports, std::vector<float>& probability) {
+        FlightGraph graph = buildSyntheticNetwork(airports, 6, 42);
+        std::mt19937 rng(3);
+        probability.resize(graph.edgeCount());
+        for (float& p : probability) p = 0.002f + 0.03f * (rng() % 1000) / 1000.0f;
+        return graph;
+    };
+    const std::vector<Criterion> all = {Criterion::Distance, Criterion::WeatherRisk, Criterion::Fare};
+    std::vector<float> probability;
+
+    std::cout << std::left << std::setw(10) << "Airports" << std::setw(12) << "Labels" << std::setw(10) << "Routes"
+              << std::setw(13) << "Largest set" << std::setw(12) << "Pool (KB)" << std::setw(12) << "ms/query"
+              << std::endl;
+    ParetoRun last;
+    for (int airports = 100; airports <= maxAirports; airports *= 2)
+    {
+        FlightGraph graph = network(airports, probability);
+        RouteCriteria criteria = makeRouteCriteria(graph, all, &probability);
+        last = runPareto(graph, criteria, ParetoOptions(), queryCount);
+        std::cout << std::left << std::setw(10) << airports << std::setw(12) << std::fixed << std::setprecision(0)
+                  << last.labels << std::setw(10) << std::setprecision(1) << last.routes << std::setw(13)
+                  << last.largestSet << std::setw(12) << last.poolBytes / 1024 << std::setw(12) << std::setprecision(2)
+                  << last.seconds * 1000 << std::endl;
+    }
+    printLine();
+
+    // The same queries with fewer criteria, and on the largest network with
+    // a label pool a tenth of what they needed.
+    int airports = std::min(maxAirports, 400);
+    FlightGraph graph = network(airports, probability);
+    std::cout << "By criteria, " << airports << " airports:" << std::endl;
+    for (size_t count = 1; count <= all.size(); ++count)
+    {
+        std::vector<Criterion> kinds(all.begin(), all.begin() + count);
+        ParetoRun run = runPareto(graph, makeRouteCriteria(graph, kinds, &probability), ParetoOptions(), queryCount);
+        std::string names;
+        for (Criterion c : kinds) names += std::string(names.empty() ? "" : ",") + criterionName(c);
+        std::cout << "  " << std::left << std::setw(22) << names << std::setprecision(0) << run.labels
+                  << " labels, " << std::setprecision(1) << run.routes << " routes, " << std::setprecision(2)
+                  << run.seconds * 1000 << " ms" << std::endl;
+    }
+
+    int largest = 100;
+    while (largest * 2 <= maxAirports) largest *= 2;
+    graph = network(largest, probability);
+    ParetoOptions bounded;
+    bounded.maxLabels = std::max(1, static_cast<int>(last.labels / 10));
+    ParetoRun run = runPareto(graph, makeRouteCriteria(graph, all, &probability), bounded, queryCount);
+    std::cout << "Pool of " << bounded.maxLabels << " labels (" << run.poolBytes / 1024 << " KB), "
+              << largest << " airports: " << run.truncated << "/" << queryCount << " truncated, "
+              << std::setprecision(1) << run.routes << " routes found, " << std::setprecision(2)
+              << run.seconds * 1000 << " ms/query" << std::endl;
+    printLine();
+}
+
+void benchForecast(int airports, int queryCount, double stormyFraction)
+{
+    printLine('=');
+    std::cout << "FORECAST ROUTING (TIME-DEPENDENT)" << std::endl;
+    printLine('=');
+
+    // A 24-hour forecast: on stormy legs a sample every 0.5 to 3 hours,
+    // slowing them by up to 3x or (one in ten) closing them.
+    FlightGraph graph = buildSyntheticNetwork(airports, 6, 42);
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<ForecastSample> samples;
+    for (int e = 0; e < graph.edgeCount(); ++e)
+    {
+        if (unit(rng) >= stormyFraction) continue;
+        for (float hour = 2.0f * unit(rng); hour < 24.0f; hour += 0.5f + 2.5f * unit(rng))
+            samples.push_back({e, hour, unit(rng) < 0.1f ? 0.0f : 1.0f + 2.0f * unit(rng)});
+    }
+    auto start = std::chrono::steady_clock::now();
+    TravelTimes times = buildTravelTimes(graph, samples);
+    std::cout << samples.size() << " samples on " << std::fixed << std::setprecision(0) << stormyFraction * 100
+              << "% of " << graph.edgeCount() << " legs: " << times.pool.size() << " breakpoints, "
+              << times.bytes() / 1024 << " KB, built in " << std::setprecision(1) << secondsSince(start) * 1000
+              << " ms" << std::endl;
+
+    const int lookups = 1 << 22;
+    std::vector<int> edges(lookups);
+    std::vector<float> hours(lookups);
+    for (int k = 0; k < lookups; ++k)
+    {
+        edges[k] = static_cast<int>(rng() % graph.edgeCount());
+        hours[k] = 24.0f * unit(rng);
+    }
+    start = std::chrono::steady_clock::now();
+    double checksum = 0.0;
+    for (int k = 0; k < lookups; ++k) checksum += std::min(times.at(edges[k], hours[k]), 100.0f);
+    double lookupSeconds = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    double weightChecksum = 0.0;
+    for (int k = 0; k < lookups; ++k) weightChecksum += graph.edgeWeight[edges[k]];
+    double weightSeconds = secondsSince(start);
+    std::cout << "Travel time lookup: " << std::setprecision(2) << lookupSeconds * 1e9 / lookups << " ns, against "
+              << weightSeconds * 1e9 / lookups << " ns to read a static weight (checksums " << std::setprecision(0)
+              << checksum << ", " << weightChecksum << ")" << std::endl;
+    printLine();
+
+    std::vector<std::array<int, 2>> queries(queryCount);
+    std::vector<double> departures(queryCount);
+    for (int q = 0; q < queryCount; ++q)
+    {
+        queries[q] = {static_cast<int>(rng() % airports), static_cast<int>(rng() % airports)};
+        departures[q] = 12.0 * unit(rng);
+    }
+
+    std::cout << std::left << std::setw(26) << "Search" << std::setw(12) << "ms/query" << std::setw(12) << "Settled"
+              << std::setw(14) << "Mean hours" << std::endl;
+    GraphView view(graph);
+    std::vector<int> path;
+    SearchStats stats;
+    std::vector<std::vector<int>> staticRoutes(queryCount);
+    std::vector<double> forecastHours(queryCount, -1.0);
+    auto report = [&](const std::string& name, double seconds, long long settled, double hoursTotal, int found) {
+        std::cout << std::left << std::setw(26) << name << std::setw(12) << std::setprecision(3)
+                  << seconds * 1000 / queryCount << std::setw(12) << std::setprecision(0)
+                  << double(settled) / queryCount << std::setw(14) << std::setprecision(3)
+                  << hoursTotal / std::max(1, found) << std::endl;
+    };
+    {
+        long long settled = 0;
+        double hoursTotal = 0.0;
+        int found = 0;
+        start = std::chrono::steady_clock::now();
+        for (int q = 0; q < queryCount; ++q)
+        {
+            view.shortestPath(queries[q][0], queries[q][1], staticRoutes[q], SearchMode::AStar, &stats);
+            settled += stats.settled;
+            if (staticRoutes[q].empty()) continue;
+            hoursTotal += stats.distance / 250.0;
+            ++found;
+        }
+        report("Static A* (clear skies)", secondsSince(start), settled, hoursTotal, found);
+    }
+    int mismatches = 0;
+    for (SearchMode mode : {SearchMode::Dijkstra, SearchMode::AStar})
+    {
+        long long settled = 0;
+        double hoursTotal = 0.0;
+        int found = 0;
+        start = std::chrono::steady_clock::now();
+        for (int q = 0; q < queryCount; ++q)
+        {
+            fastestRoute(view, times, queries[q][0], queries[q][1], departures[q], path, mode, &stats);
+            settled += stats.settled;
+            if (path.empty()) continue;
+            hoursTotal += stats.distance;
+            ++found;
+            if (mode == SearchMode::Dijkstra) forecastHours[q] = stats.distance;
+            else if (std::fabs(forecastHours[q] - stats.distance) > 1e-6 * std::max(1.0, stats.distance)) ++mismatches;
+        }
+        report(mode == SearchMode::Dijkstra ? "Time-dependent Dijkstra" : "Time-dependent A*", secondsSince(start),
+               settled, hoursTotal, found);
+    }
+    printLine();
+    if (mismatches) std::cout << "ERROR: " << mismatches << " A* travel times differ from Dijkstra" << std::endl;
+
+    // What the forecast changes: the clear-sky route flown at the
+    // forecast's travel times, against the fastest route.
+    int rerouted = 0, compared = 0;
+    double saved = 0.0;
+    for (int q = 0; q < queryCount; ++q)
+    {
+        if (staticRoutes[q].empty() || forecastHours[q] < 0.0) continue;
+        double t = departures[q];
+        const std::vector<int>& route = staticRoutes[q];
+        for (size_t k = 0; k + 1 < route.size(); ++k) t += times.at(graph.findEdge(route[k], route[k + 1]), static_cast<float>(t));
+        double flown = t - departures[q];
+        ++compared;
+        if (flown > forecastHours[q] + 1e-6)
+        {
+            ++rerouted;
+            saved += flown - forecastHours[q];
+        }
+    }
+    std::cout << "Forecast-aware route faster than the clear-sky one for " << rerouted << "/" << compared
+              << " queries, saving " << std::setprecision(2) << (rerouted ? saved / rerouted : 0.0)
+              << " hours on average" << std::endl;
+    printLine();
+}
+
+void benchWeather(int airports, int bulletinEdges)
+{
+    printLine('=');
+    std::cout << "WEATHER LAYERS" << std::endl;
+    printLine('=');
+
+    FlightGraph graph = buildSyntheticNetwork(airports, 6, 42);
+    int m = graph.edgeCount();
+    std::cout << "Network: " << graph.airportCount() << " airports, " << m << " edges" << std::endl;
+
+    std::mt19937 rng(3);
+    std::vector<int> edges(bulletinEdges);
+    for (int& e : edges) e = static_cast<int>(rng() % m);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int e : edges) graph.updateWeather(graph.edgeFrom[e], graph.edgeTo[e], true, "Storm");
+    double perEdge = secondsSince(start);
+    for (int e : edges) graph.updateWeather(graph.edgeFrom[e], graph.edgeTo[e], false, "Clear");
+
+    EdgeMask bulletin(m);
+    for (int e : edges) bulletin.set(e);
+    const int rounds = 100;
+    std::vector<int> changed;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+        graph.setHazardLayer(r % 2 ? Hazard::Ice : Hazard::Storm, bulletin);
+    double layer = secondsSince(start) / rounds;
+    graph.setHazardLayer(Hazard::Ice, EdgeMask(m));
+    graph.setHazardLayer(Hazard::Storm, EdgeMask(m));
+    graph.setHazardLayer(Hazard::Storm, bulletin, &changed);
+
+    int unavailable = 0;
+    for (int e = 0; e < m; ++e) unavailable += !graph.isAvailable(e);
+    std::cout << "Bulletin of " << bulletinEdges << " edges (" << unavailable << " distinct, " << changed.size()
+              << " changed):" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  per-edge updateWeather: " << perEdge * 1e6 << " us" << std::endl;
+    std::cout << "  setHazardLayer:         " << layer * 1e6 << " us" << std::endl;
+
+    // Path checks on random 12-edge paths through the edge ids.
+    const int checks = 200000, length = 12;
+    std::vector<int> paths(static_cast<size_t>(checks) * length);
+    for (int& e : paths) e = static_cast<int>(rng() % m);
+    long long hits = 0;
+    start = std::chrono::steady_clock::now();
+    for (int c = 0; c < checks; ++c)
+        hits += anyEdgeUnavailable(graph.availableBits.data(), paths.data() + static_cast<size_t>(c) * length, length);
+    std::cout << "  path check (12 edges):  " << std::setprecision(3) << secondsSince(start) * 1e9 / checks
+              << " ns, " << hits << " of " << checks << " paths blocked" << std::endl;
+
+    // Descriptions go to layers by their words, not by substrings.
+    const std::pair<const char*, Hazard> descriptions[] = {
+        {"Thunderstorms", Hazard::Storm}, {"Snowstorm", Hazard::Storm},     {"Freezing rain", Hazard::Ice},
+        {"Icing", Hazard::Ice},           {"Dense fog", Hazard::Fog},       {"Wind shear", Hazard::Wind},
+        {"Crosswinds", Hazard::Wind},     {"Runway closed", Hazard::Closure}, {"Volcanic ash", Hazard::Closure},
+        {"Ash cloud", Hazard::Closure},   {"Service disruption", Hazard::Other}, {"ATC notice", Hazard::Other},
+        {"Flash flooding", Hazard::Other}, {"Washington advisory", Hazard::Other}, {"Hazard", Hazard::Other}};
+    int classified = 0;
+    for (const auto& [text, hazard] : descriptions)
+    {
+        if (classifyHazard(text) == hazard) ++classified;
+        else std::cout << "ERROR: \"" << text << "\" classified as " << hazardName(classifyHazard(text)) << std::endl;
+    }
+    std::cout << "  classifier:             " << classified << " of " << std::size(descriptions)
+              << " descriptions on the right layer" << std::endl;
+    printLine();
+}
+
+// Ingests the same random feed as text and as binary records, epoch by
+// epoch, and reports throughput and the worst apply latency.
+void benchFeed(int airports, int updates, int epochSize)
+{
+    printLine('=');
+    std::cout << "WEATHER FEED" << std::endl;
+    printLine('=');
+
+    FlightGraph graph = buildSyntheticNetwork(airports, 6, 42);
+    int m = graph.edgeCount();
+    std::cout << "Network: " << graph.airportCount() << " airports, " << m << " edges" << std::endl;
+
+    const char* descriptions[] = {"Thunderstorm", "Freezing rain", "Dense fog", "Wind shear", "Airspace closed"};
+    std::mt19937 rng(5);
+    std::ostringstream text, binary;
+    binary.write(kWeatherFeedMagic, sizeof kWeatherFeedMagic);
+    for (int i = 0; i < updates; ++i)
+    {
+        int e = static_cast<int>(rng() % m);
+        bool isBad = rng() % 3 != 0;
+        int hazard = static_cast<int>(rng() % 5);
+        text << graph.airports[graph.edgeFrom[e]].code << ' ' << graph.airports[graph.edgeTo[e]].code << ' ' << isBad;
+        if (isBad) text << ' ' << descriptions[hazard];
+        text << '\n';
+        WeatherFeedRecord record = {graph.edgeFrom[e], graph.edgeTo[e], static_cast<std::uint8_t>(isBad),
+                                    static_cast<std::uint8_t>(hazard), 0};
+        binary.write(reinterpret_cast<const char*>(&record), sizeof record);
+    }
+
+    auto ingest = [&](const std::string& name, const std::string& feed) {
+        std::istringstream in(feed);
+        WeatherFeedReader reader(in, graph, epochSize);
+        WeatherEpochStats stats;
+        std::vector<int> changed;
+        long long applied = 0, changedEdges = 0;
+        double worstApply = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        while (reader.nextEpoch(stats, changed))
+        {
+            applied += stats.applied;
+            changedEdges += stats.changed;
+            worstApply = std::max(worstApply, stats.applySeconds);
+        }
+        double seconds = secondsSince(start);
+        std::cout << std::left << std::setw(8) << name << std::right << std::fixed << std::setprecision(2)
+                  << feed.size() / 1e6 << " MB, " << reader.epochs() << " epochs, " << applied << " applied, "
+                  << changedEdges << " changed, " << std::setprecision(0) << updates / seconds << " updates/s, "
+                  << "worst apply " << std::setprecision(1) << worstApply * 1e6 << " us" << std::endl;
+    };
+    ingest("text", text.str());
+    ingest("binary", binary.str());
+    printLine();
+}
+
+// Stress test for WeatherEpochs. In epoch k exactly the edges with
+// (e + k) % kStripe == 0 are bad, so a reader can check any edge of its
+// pinned snapshot against the snapshot's epoch; a mismatch is a torn read.
+// Readers also route and check that no edge of the route is bad in the
+// snapshot that was searched.
+void benchEpochs(int airports, int readerCount, double seconds)
+{
+    printLine('=');
+    std::cout << "CONCURRENT WEATHER EPOCHS" << std::endl;
+    printLine('=');
+
+    const int kStripe = 61;
+    FlightGraph base = buildSyntheticNetwork(airports, 6, 42);
+    int n = base.airportCount(), m = base.edgeCount();
+    std::cout << "Network: " << n << " airports, " << m << " edges, " << readerCount << " readers, "
+              << (m + kStripe - 1) / kStripe << " bad edges per epoch" << std::endl;
+
+    WeatherEpochs weather(base);
+    {
+        FlightGraph& g = weather.beginUpdate();
+        std::vector<WeatherUpdate> updates;
+        std::uint32_t storm = g.internDescription("Storm");
+        for (int e = kStripe - 1; e < m; e += kStripe) updates.push_back({e, true, storm});
+        g.applyWeatherUpdates(updates);
+        weather.publish();
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<long long> reads{0}, routes{0}, torn{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < readerCount; ++r)
+    {
+        readers.emplace_back([&, r] {
+            WeatherReader reader(weather);
+            std::mt19937 rng(100 + r);
+            std::vector<int> path, edges;
+            long long localReads = 0, localRoutes = 0, localTorn = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                PinnedWeather pinned(reader);
+                const FlightGraph& g = pinned.graph;
+                auto bad = [&](int e) { return static_cast<int>((e + pinned.epoch) % kStripe) == 0; };
+                for (int i = 0; i < 64; ++i)
+                {
+                    int e = static_cast<int>(rng() % m);
+                    localTorn += g.isAvailable(e) == bad(e);
+                }
+                localReads += 64;
+                if (localReads % 4096 == 0)
+                {
+                    GraphView(g).shortestPath(static_cast<int>(rng() % n), static_cast<int>(rng() % n), path,
+                                              SearchMode::BidirectionalAStar);
+                    g.pathEdges(path, edges);
+                    for (int e : edges) localTorn += bad(e) || !g.isAvailable(e);
+                    ++localRoutes;
+                }
+            }
+            reads += localReads;
+            routes += localRoutes;
+            torn += localTorn;
+        });
+    }
+
+    std::vector<WeatherUpdate> updates;
+    double worstGrace = 0.0, applyTotal = 0.0;
+    long long epochs = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (secondsSince(start) < seconds)
+    {
+        FlightGraph& g = weather.beginUpdate();
+        worstGrace = std::max(worstGrace, weather.graceSeconds());
+        auto applyStart = std::chrono::steady_clock::now();
+        std::uint64_t k = weather.epoch();
+        std::uint32_t storm = g.internDescription("Storm");
+        updates.clear();
+        for (int e = static_cast<int>((kStripe - k % kStripe) % kStripe); e < m; e += kStripe)
+            updates.push_back({e, false, 0});
+        for (int e = static_cast<int>((kStripe - (k + 1) % kStripe) % kStripe); e < m; e += kStripe)
+            updates.push_back({e, true, storm});
+        g.applyWeatherUpdates(updates);
+        applyTotal += secondsSince(applyStart);
+        weather.publish();
+        ++epochs;
+    }
+    stop = true;
+    for (auto& t : readers) t.join();
+    double elapsed = secondsSince(start);
+
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "Epochs published: " << epochs << " (" << epochs / elapsed << "/s)" << std::endl;
+    std::cout << "Edge reads:       " << reads.load() << " (" << reads.load() / elapsed << "/s)" << std::endl;
+    std::cout << "Routes:           " << routes.load() << std::endl;
+    std::cout << std::setprecision(1) << "Avg update+copy:  " << applyTotal / std::max(1LL, epochs) * 1e6 << " us"
+              << std::endl;
+    std::cout << "Worst grace wait: " << worstGrace * 1e6 << " us" << std::endl;
+    std::cout << "Torn reads:       " << torn.load() << std::endl;
+    printLine();
+}
+
+// Round-trip latency of ROUTE requests to an in-process routing service,
+// set against what a fresh process pays to build the graph first.
+void benchService(int airports, int requests, const std::string& path)
+{
+    printLine('=');
+    std::cout << "ROUTING SERVICE" << std::endl;
+    printLine('=');
+
+    auto start = std::chrono::steady_clock::now();
+    FlightGraph graph = buildSyntheticNetwork(airports, 6, 42);
+    double build = secondsSince(start);
+    int n = graph.airportCount();
+    std::cout << "Network: " << n << " airports, " << graph.edgeCount() << " edges, built in " << std::fixed
+              << std::setprecision(1) << build * 1000 << " ms" << std::endl;
+
+    RouteService service(graph, SearchMode::BidirectionalAStar);
+    std::ostringstream serviceLog;
+    std::thread server([&] { service.run(path, serviceLog); });
+    LocalSocket client;
+    for (int attempt = 0; attempt < 100 && !client.connect(path); ++attempt)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (!client.isOpen())
+    {
+        std::cerr << "Could not connect to " << path << std::endl;
+        service.stop();
+        server.join();
+        return;
+    }
+
+    std::mt19937 rng(9);
+    std::vector<double> latency;
+    std::string reply;
+    auto roundTrip = [&](const std::string& request) {
+        auto sent = std::chrono::steady_clock::now();
+        client.sendLine(request);
+        client.readLine(reply);
+        return secondsSince(sent);
+    };
+    for (int i = 0; i < 200; ++i) roundTrip("PING");
+    std::vector<double> ping;
+    for (int i = 0; i < 2000; ++i) ping.push_back(roundTrip("PING"));
+    for (int i = 0; i < requests; ++i)
+    {
+        int src = static_cast<int>(rng() % n), dst = static_cast<int>(rng() % n);
+        latency.push_back(roundTrip("ROUTE " + std::to_string(src) + " " + std::to_string(dst)));
+        if (i % 100 == 0) roundTrip("WEATHER " + std::to_string(graph.edgeFrom[src % graph.edgeCount()]) + " " +
+                                    std::to_string(graph.edgeTo[src % graph.edgeCount()]) + " " + std::to_string(i / 100 % 2) + " Storm");
+    }
+    client.sendLine("SHUTDOWN");
+    client.readLine(reply);
+    server.join();
+
+    auto percentile = [](std::vector<double>& v, double p) {
+        std::sort(v.begin(), v.end());
+        return v[std::min(v.size() - 1, static_cast<size_t>(p * v.size()))] * 1e6;
+    };
+    std::cout << "PING round trip:  p50 " << percentile(ping, 0.5) << " us, p99 " << percentile(ping, 0.99) << " us"
+              << std::endl;
+    std::cout << "ROUTE round trip: p50 " << percentile(latency, 0.5) << " us, p99 " << percentile(latency, 0.99)
+              << " us over " << requests << " requests" << std::endl;
+    printLine();
+}
+
+int main(int argc, char* argv[])
+{
+    std::string which = argc > 1 ? argv[1] : "matrix";
+
+    if (which == "matrix")
+    {
+        int airports = argc > 2 ? std::stoi(argv[2]) : 20000;
+        int sources = argc > 3 ? std::stoi(argv[3]) : 256;
+        int targets = argc > 4 ? std::stoi(argv[4]) : 256;
+        unsigned threads = argc > 5 ? std::stoi(argv[5]) : std::max(1u, std::thread::hardware_concurrency());
+        benchRouteMatrix(airports, sources, targets, threads);
+    }
+    else if (which == "heaps")
+    {
+        int queries = argc > 2 ? std::stoi(argv[2]) : 400;
+        benchQueues(queries);
+    }
+    else if (which == "load" && argc == 4)
+    {
+        benchLoad(argv[2], argv[3]);
+    }
+    else if (which == "snapshot")
+    {
+        int airports = argc > 2 ? std::stoi(argv[2]) : 200000;
+        std::string path = argc > 3 ? argv[3] : "route_bench.graph";
+        benchSnapshot(airports, path);
+    }
+    else if (which == "spatial")
+    {
+        int airports = argc > 2 ? std::stoi(argv[2]) : 50000;
+        int k = argc > 3 ? std::stoi(argv[3]) : 6;
+        unsigned threads = argc > 4 ? std::stoi(argv[4]) : std::max(1u, std::thread::hardware_concurrency());
+        benchSpatial(airports, k, threads);
+    }
+    else if (which == "cull")
+    {
+        int airports = argc > 2 ? std::stoi(argv[2]) : 100000;
+        int views = argc > 3 ? std::stoi(argv[3]) : 200;
+        benchCull(airports, views);
+    }
+    else if (which == "fleet")
+    {
+        int aircraft = argc > 2 ? std::stoi(argv[2]) : 100000;
+        int routes = argc > 3 ? std::stoi(argv[3]) : 2000;
+        int steps = argc > 4 ? std::stoi(argv[4]) : 600;
+        benchFleet(aircraft, routes, steps);
+    }
+    else if (which == "simulation")
+    {
+        int aircraft = argc > 2 ? std::stoi(argv[2]) : 10000;
+        double seconds = argc > 3 ? std::stod(argv[3]) : 4.0;
+        benchSimulation(aircraft, seconds);
+    }
+    else if (which == "events")
+    {
+        int airports = argc > 2 ? std::stoi(argv[2]) : 2000;
+        int aircraft = argc > 3 ? std::stoi(argv[3]) : 20000;
+        double hours = argc > 4 ? std::stod(argv[4]) : 48.0;
+        benchEvents(airports, aircraft, hours);
+    }
+    else if (which == "scenarios")
+    {
+        int airports = argc > 2 ? std::stoi(argv[2]) : 5000;
+        int pairs = argc > 3 ? std::stoi(argv[3]) : 100;
+        int scenarios = argc > 4 ? std::stoi(argv[4]) : 500;
+        unsigned threads = argc > 5 ? std::stoi(argv[5]) : std::max(1u, std::thread::hardware_concurrency());
+        benchScenarios(airports, pairs, scenarios, threads);
+    }
+    else if (which == "timetable")
+    {
+        int airports = argc > 2 ? std::stoi(argv[2]) : 2000;
+        int flights = argc > 3 ? std::stoi(argv[3]) : 16;
+        int queries = argc > 4 ? std::stoi(argv[4]) : 200;
+        benchTimetable(airports, flights, queries);
+    }
+    else if (which == "pareto")
+    {
+        int airports = argc > 2 ? std::stoi(argv[2]) : 1600;
+        int queries = argc > 3 ? std::stoi(argv[3]) : 10;
+        benchPareto(airports, queries);
+    }
+    else if (which == "forecast")
+    {
+        int airports = argc > 2 ? std::stoi(argv[2]) : 20000;
+        int queries = argc > 3 ? std::stoi(argv[3]) : 200;
+        double stormy = argc > 4 ? std::stod(argv[4]) : 0.2;
+        benchForecast(airports, queries, stormy);
+    }
+    else if (which == "weather")
+    {
+        int airports = argc > 2 ? std::stoi(argv[2]) : 200000;
+        int edges = argc > 3 ? std::stoi(argv[3]) : 10000;
+        benchWeather(airports, edges);
+    }
+    else if (which == "feed")
+    {
+        int airports = argc > 2 ? std::stoi(argv[2]) : 200000;
+        int updates = argc > 3 ? std::stoi(argv[3]) : 1000000;
+        int epochSize = argc > 4 ? std::stoi(argv[4]) : 4096;
+        benchFeed(airports, updates, epochSize);
+    }
+    else if (which == "epochs")
+    {
+        int airports = argc > 2 ? std::stoi(argv[2]) : 50000;
+        int readers = argc > 3 ? std::stoi(argv[3]) : 4;
+        double seconds = argc > 4 ? std::stod(argv[4]) : 3.0;
+        benchEpochs(airports, readers, seconds);
+    }
+    else if (which == "service")
+    {
+        int airports = argc > 2 ? std::stoi(argv[2]) : 50000;
+        int requests = argc > 3 ? std::stoi(argv[3]) : 20000;
+        std::string path = argc > 4 ? argv[4] : "route_bench.sock";
+        benchService(airports, requests, path);
+    }
+    else
+    {
+        std::cerr << "Usage: route_bench matrix [airports] [sources] [targets] [max_threads]" << std::endl;
+        std::cerr << "       route_bench heaps [queries]" << std::endl;
+        std::cerr << "       route_bench load <airports.dat> <routes.dat>" << std::endl;
+        std::cerr << "       route_bench snapshot [airports] [file]" << std::endl;
+        std::cerr << "       route_bench spatial [airports] [k] [max_threads]" << std::endl;
+        std::cerr << "       route_bench cull [airports] [views]" << std::endl;
+        std::cerr << "       route_bench fleet [aircraft] [routes] [steps]" << std::endl;
+        std::cerr << "       route_bench simulation [aircraft] [seconds]" << std::endl;
+        std::cerr << "       route_bench events [airports] [aircraft] [hours]" << std::endl;
+        std::cerr << "       route_bench scenarios [airports] [pairs] [scenarios] [max_threads]" << std::endl;
+        std::cerr << "       route_bench timetable [airports] [flights_per_leg] [queries]" << std::endl;
+        std::cerr << "       route_bench pareto [max_airports] [queries]" << std::endl;
+        std::cerr << "       route_bench forecast [airports] [queries] [stormy_fraction]" << std::endl;
+        std::cerr << "       route_bench weather [airports] [bulletin_edges]" << std::endl;
+        std::cerr << "       route_bench feed [airports] [updates] [epoch_size]" << std::endl;
+        std::cerr << "       route_bench epochs [airports] [readers] [seconds]" << std::endl;
+        std::cerr << "       route_bench service [airports] [requests] [socket]" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "flight_graph.hpp"
+#include "thread_pool.hpp"
+
+// Dense origin-destination table: row i belongs to sources[i], column j to
+// targets[j]. paths is only filled when requested.
+struct RouteMatrix
+{
+    std::vector<int> sources;
+    std::vector<int> targets;
+    std::vector<double> distance;
+    std::vector<std::vector<int>> paths;
+
+    double at(size_t i, size_t j) const { return distance[i * targets.size() + j]; }
+    const std::vector<int>& pathAt(size_t i, size_t j) const { return paths[i * targets.size() + j]; }
+};
+
+// One-to-many Dijkstra on a view. Stops as soon as every target is
+// settled; results stay in ws.labels[0] until the workspace is reused.
+template <typename Queue = LazyHeap>
+void searchOneToMany(const GraphView& view, int src, const std::vector<int>& targets,
+                     SearchWorkspace& ws = SearchWorkspace::local())
+{
+    const FlightGraph& g = *view.graph;
+    int n = g.airportCount();
+    SearchLabels& labels = ws.labels[0];
+    Queue& queue = ws.queue<Queue>(0);
+    ws.begin<Queue>(n);
+    ws.beginMarks(n);
+
+    int pending = 0;
+    for (int t : targets)
+    {
+        if (!ws.isMarked(t)) ++pending;
+        ws.mark(t);
+    }
+
+    labels.set(src, 0, -1);
+    queue.push(0, src);
+
+    while (!queue.empty() && pending > 0)
+    {
+        auto [d, u] = queue.pop();
+        if (d > labels.dist[u]) continue;
+        if (ws.isMarked(u))
+        {
+            ws.unmark(u);
+            --pending;
+        }
+
+        for (int a = g.arcOffset[u]; a < g.arcOffset[u + 1]; ++a)
+        {
+            if (!view.isAvailable(g.arcEdge[a])) continue;
+
+            int v = g.arcTarget[a];
+            double alt = d + g.arcWeight[a];
+            if (alt < labels.distance(v))
+            {
+                labels.set(v, alt, u);
+                queue.push(alt, v);
+            }
+        }
+    }
+}
+
+// Runs one one-to-many search per source across the pool.
+inline RouteMatrix computeRouteMatrix(const GraphView& view, const std::vector<int>& sources,
+                                      const std::vector<int>& targets, WorkStealingPool& pool,
+                                      bool withPaths = false)
+{
+    RouteMatrix matrix;
+    matrix.sources = sources;
+    matrix.targets = targets;
+    matrix.distance.assign(sources.size() * targets.size(), std::numeric_limits<double>::infinity());
+    if (withPaths) matrix.paths.resize(sources.size() * targets.size());
+
+    pool.run(static_cast<int>(sources.size()), [&](int i, unsigned) {
+        SearchWorkspace& ws = SearchWorkspace::local();
+        searchOneToMany(view, sources[i], targets, ws);
+        const SearchLabels& labels = ws.labels[0];
+
+        size_t row = static_cast<size_t>(i) * targets.size();
+        for (size_t j = 0; j < targets.size(); ++j)
+        {
+            double d = labels.distance(targets[j]);
+            matrix.distance[row + j] = d;
+            if (!withPaths || d == std::numeric_limits<double>::infinity()) continue;
+
+            std::vector<int>& path = matrix.paths[row + j];
+            for (int at = targets[j]; at != -1; at = labels.parent(at))
+                path.push_back(at);
+            std::reverse(path.begin(), path.end());
+        }
+    });
+    return matrix;
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include "route_batch.hpp"
+#include "weather_epochs.hpp"
+#include "local_socket.hpp"
+#include <condition_variable>
+#include <iostream>
+#include <ostream>
+
+// Long-lived routing service on a local socket, so clients (the booking
+// system) get routes without starting a process and rebuilding the graph.
+// Each request is one line and gets exactly one JSON line back:
+//
+//   ROUTE <a> <b>                    route as in batch mode
+//   REROUTE <a> <b> [<x> <y> ...]    same, also avoiding the legs x-y
+//   WEATHER <a> <b> <0|1> [text]     one weather update, published at once
+//   STATS                            epoch and request counters
+//   PING                             {"ok":true} and the network
+//   QUIT                             closes the connection, no reply
+//   SHUTDOWN                         {"ok":true}, then stops the service
+//
+// Airports are given by index or code; errors come back as
+// {"error":"..."}. Every connection has its own thread and reads the
+// weather through WeatherEpochs, so routes keep being answered while
+// updates are published. PING and STATS also give the network the
+// service has loaded, "airports":N,"edges":M,"network":"<fingerprint>"
+// (networkFingerprint in hex), so a client can check it is the same as
+// its own before trusting the routes.
+struct RouteService
+{
+    explicit RouteService(const FlightGraph& graph, SearchMode searchMode = SearchMode::Dijkstra)
+        : weather(graph), airports(graph), mode(searchMode)
+    {
+        char fingerprint[32];
+        std::snprintf(fingerprint, sizeof fingerprint, "%016llx",
+                      static_cast<unsigned long long>(networkFingerprint(graph)));
+        network = "\"airports\":" + std::to_string(graph.airportCount()) + ",\"edges\":" +
+                  std::to_string(graph.edgeCount()) + ",\"network\":\"" + fingerprint + "\"";
+    }
+
+    RouteService(const RouteService&) = delete;
+    RouteService& operator=(const RouteService&) = delete;
+
+    // Serves on path until SHUTDOWN or stop(). Returns false if the socket
+    // cannot be opened.
+    bool run(const std::string& path, std::ostream& log)
+    {
+        socketPath = path;
+        std::string error;
+        if (!listener.listen(path, error))
+        {
+            std::cerr << "Could not listen on " << path << ": " << error << std::endl;
+            return false;
+        }
+        log << "Routing service listening on " << path << std::endl;
+
+        int failedAccepts = 0;
+        for (;;)
+        {
+            LocalSocket client = listener.accept();
+            if (stopping.load()) break;
+            if (!client.isOpen())
+            {
+                // Out of descriptors or similar: wait for connections to
+                // close instead of spinning on accept.
+                if (failedAccepts++ == 0) log << "Could not accept a connection, retrying" << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(std::min(1000, 10 << std::min(failedAccepts, 7))));
+                continue;
+            }
+            failedAccepts = 0;
+
+            std::lock_guard<std::mutex> lock(clientsLock);
+            ++active;
+            std::thread([this](LocalSocket socket) {
+                serve(socket);
+                std::lock_guard<std::mutex> done(clientsLock);
+                --active;
+                finished.notify_all();
+            }, std::move(client)).detach();
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(clientsLock);
+            finished.wait(lock, [&] { return active == 0; });
+        }
+        listener.removeBoundPath();
+        listener.close();
+        log << "Routing service stopped after " << routes.load() << " routes and " << updates.load()
+            << " weather updates" << std::endl;
+        return true;
+    }
+
+    // Makes run() return once the open connections are closed.
+    void stop()
+    {
+        if (stopping.exchange(true)) return;
+        std::lock_guard<std::mutex> lock(clientsLock);
+        for (LocalSocket* client : clients) client->shutdown();
+        // accept() is woken portably by one last connection, as long as the
+        // path still leads here; otherwise shutting the listener down
+        // wakes it where the platform allows.
+        if (listener.ownsBoundPath())
+        {
+            LocalSocket wake;
+            wake.connect(socketPath);
+        }
+        else
+        {
+            listener.shutdown();
+        }
+    }
+
+    // Answers one request line into response (ending in '\n'). Returns
+    // false when the connection should be closed.
+    bool handle(const std::string& request, WeatherReader& reader, std::string& response)
+    {
+        response.clear();
+        std::string_view rest(request);
+        std::string_view command = nextToken(rest);
+
+        if (command == "ROUTE" || command == "REROUTE")
+        {
+            int src = airports.find(nextToken(rest));
+            int dst = airports.find(nextToken(rest));
+            if (src < 0 || dst < 0) return reply(response, "{\"error\":\"unknown airport\"}");
+            if (command == "ROUTE" && !nextToken(rest).empty()) return reply(response, "{\"error\":\"ROUTE takes two airports\"}");
+
+            thread_local RouteResult result;
+            thread_local std::vector<int> directPath, edges;
+            PinnedWeather pinned(reader);
+            GraphView view(pinned.graph);
+            for (std::string_view x = nextToken(rest); !x.empty(); x = nextToken(rest))
+            {
+                int u = airports.find(x), v = airports.find(nextToken(rest));
+                if (u < 0 || v < 0) return reply(response, "{\"error\":\"unknown airport\"}");
+                int e = pinned.graph.findEdge(u, v);
+                if (e < 0) return reply(response, "{\"error\":\"no such leg\"}");
+                view.setEdgeAvailable(e, false);
+            }
+            answerRoute(view, src, dst, mode, result, directPath, edges);
+            appendRouteJson(response, pinned.graph, src, dst, result);
+            ++routes;
+            return true;
+        }
+        if (command == "WEATHER")
+        {
+            int a = airports.find(nextToken(rest));
+            int b = airports.find(nextToken(rest));
+            std::string_view flag = nextToken(rest);
+            if (a < 0 || b < 0) return reply(response, "{\"error\":\"unknown airport\"}");
+            if (flag != "0" && flag != "1") return reply(response, "{\"error\":\"condition must be 0 or 1\"}");
+            size_t begin = rest.find_first_not_of(" \t");
+            std::string description = begin == std::string_view::npos ? "Bad weather" : std::string(rest.substr(begin));
+
+            // Legs are the same in every epoch, so a missing one is caught
+            // without starting an update.
+            {
+                PinnedWeather pinned(reader);
+                if (pinned.graph.findEdge(a, b) < 0) return reply(response, "{\"error\":\"no such leg\"}");
+            }
+            FlightGraph& next = weather.beginUpdate();
+            int e = next.findEdge(a, b);
+            bool wasAvailable = next.isAvailable(e);
+            next.updateWeather(a, b, flag == "1", description);
+            bool changed = next.isAvailable(e) != wasAvailable;
+            weather.publish();
+            ++updates;
+            return reply(response, std::string("{\"ok\":true,\"epoch\":") + std::to_string(weather.epoch()) +
+                                   ",\"changed\":" + (changed ? "true" : "false") + "}");
+        }
+        if (command == "STATS")
+        {
+            return reply(response, "{\"epoch\":" + std::to_string(weather.epoch()) + ",\"routes\":" +
+                                   std::to_string(routes.load()) + ",\"updates\":" + std::to_string(updates.load()) +
+                                   "," + network + "}");
+        }
+        if (command == "PING") return reply(response, "{\"ok\":true," + network + "}");
+        if (command == "QUIT") return false;
+        if (command == "SHUTDOWN")
+        {
+            reply(response, "{\"ok\":true}");
+            return false;
+        }
+        return reply(response, "{\"error\":\"unknown request\"}");
+    }
+
+private:
+    WeatherEpochs weather;
+    AirportLookup airports;
+    SearchMode mode;
+    std::string network;
+    std::atomic<long long> routes{0};
+    std::atomic<long long> updates{0};
+    std::atomic<bool> stopping{false};
+    std::string socketPath;
+    LocalSocket listener;
+    std::mutex clientsLock;
+    std::condition_variable finished;
+    std::vector<LocalSocket*> clients;
+    int active = 0;
+
+    static bool reply(std::string& response, const std::string& json)
+    {
+        response = json;
+        response += '\n';
+        return true;
+    }
+
+    void serve(LocalSocket& client)
+    {
+        WeatherReader reader(weather);
+        if (!reader.valid())
+        {
+            client.sendLine("{\"error\":\"too many connections\"}");
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(clientsLock);
+            if (stopping.load()) return;
+            clients.push_back(&client);
+        }
+
+        std::string request, response;
+        bool shutdownRequested = false;
+        while (client.readLine(request))
+        {
+            bool keepOpen = handle(request, reader, response);
+            if (!response.empty() && !client.sendAll(response.data(), response.size())) break;
+            if (!keepOpen)
+            {
+                std::string_view command(request);
+                shutdownRequested = nextToken(command) == "SHUTDOWN";
+                break;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(clientsLock);
+            clients.erase(std::find(clients.begin(), clients.end(), &client));
+        }
+        if (shutdownRequested) stop();
+    }
+};
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "flight_graph.hpp"
+#include "thread_pool.hpp"
+
+// Static 2-d tree over airport positions. The tree is implicit: each
+// range [lo, hi) of the permuted arrays is split at its middle element on
+// the wider axis, so building is a sequence of nth_element calls and the
+// tree needs no node objects. Queries are const and take the caller's
+// output buffer, so any number of threads can search one tree at once.
+struct KdTree
+{
+    static const int kLeafSize = 8;
+
+    std::vector<int> ids;
+    std::vector<float> xs;
+    std::vector<float> ys;
+    std::vector<std::uint8_t> splitOnY;
+
+    void build(const std::vector<Airport>& airports)
+    {
+        int n = static_cast<int>(airports.size());
+        ids.resize(n);
+        for (int i = 0; i < n; ++i) ids[i] = i;
+        splitOnY.assign(n, 0);
+        split(airports, 0, n);
+
+        xs.resize(n);
+        ys.resize(n);
+        for (int i = 0; i < n; ++i)
+        {
+            xs[i] = airports[ids[i]].position.x;
+            ys[i] = airports[ids[i]].position.y;
+        }
+    }
+
+    int size() const { return static_cast<int>(ids.size()); }
+
+    // The k airports closest to (x, y), nearest first, as (squared
+    // distance, airport) pairs. skip is left out (e.g. the query airport).
+    void nearest(float x, float y, int k, std::vector<std::pair<float, int>>& out, int skip = -1) const
+    {
+        out.clear();
+        if (k > 0) nearestIn(0, size(), x, y, k, skip, out);
+        std::sort_heap(out.begin(), out.end());
+    }
+
+    // Closest airport to (x, y), or -1 if the tree is empty.
+    int nearest(float x, float y) const
+    {
+        std::pair<float, int> best{std::numeric_limits<float>::infinity(), -1};
+        nearestOneIn(0, size(), x, y, best);
+        return best.second;
+    }
+
+    // Every airport within radius of (x, y), in no particular order.
+    void withinRadius(float x, float y, float radius, std::vector<int>& out, int skip = -1) const
+    {
+        out.clear();
+        radiusIn(0, size(), x, y, radius * radius, skip, out);
+    }
+
+private:
+    void split(const std::vector<Airport>& airports, int lo, int hi)
+    {
+        if (hi - lo <= kLeafSize) return;
+
+        float minX = airports[ids[lo]].position.x, maxX = minX;
+        float minY = airports[ids[lo]].position.y, maxY = minY;
+        for (int i = lo; i < hi; ++i)
+        {
+            const auto& p = airports[ids[i]].position;
+            minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+        }
+        bool byY = maxY - minY > maxX - minX;
+        int mid = (lo + hi) / 2;
+        std::nth_element(ids.begin() + lo, ids.begin() + mid, ids.begin() + hi, [&](int a, int b) {
+            const auto& pa = airports[a].position;
+            const auto& pb = airports[b].position;
+            return byY ? pa.y < pb.y : pa.x < pb.x;
+        });
+        splitOnY[mid] = byY;
+        split(airports, lo, mid);
+        split(airports, mid + 1, hi);
+    }
+
+    float squaredDistance(int i, float x, float y) const
+    {
+        float dx = xs[i] - x, dy = ys[i] - y;
+        return dx * dx + dy * dy;
+    }
+
+    // out is a max-heap on distance holding at most k entries.
+    void offer(int i, float x, float y, int k, int skip, std::vector<std::pair<float, int>>& out) const
+    {
+        if (ids[i] == skip) return;
+        float d = squaredDistance(i, x, y);
+        if (static_cast<int>(out.size()) < k)
+        {
+            out.push_back({d, ids[i]});
+            std::push_heap(out.begin(), out.end());
+        }
+        else if (d < out.front().first)
+        {
+            std::pop_heap(out.begin(), out.end());
+            out.back() = {d, ids[i]};
+            std::push_heap(out.begin(), out.end());
+        }
+    }
+
+    void nearestIn(int lo, int hi, float x, float y, int k, int skip, std::vector<std::pair<float, int>>& out) const
+    {
+        if (hi - lo <= kLeafSize)
+        {
+            for (int i = lo; i < hi; ++i) offer(i, x, y, k, skip, out);
+            return;
+        }
+        int mid = (lo + hi) / 2;
+        float diff = splitOnY[mid] ? y - ys[mid] : x - xs[mid];
+        offer(mid, x, y, k, skip, out);
+        if (diff < 0)
+        {
+            nearestIn(lo, mid, x, y, k, skip, out);
+            if (static_cast<int>(out.size()) < k || diff * diff < out.front().first)
+                nearestIn(mid + 1, hi, x, y, k, skip, out);
+        }
+        else
+        {
+            nearestIn(mid + 1, hi, x, y, k, skip, out);
+            if (static_cast<int>(out.size()) < k || diff * diff < out.front().first)
+                nearestIn(lo, mid, x, y, k, skip, out);
+        }
+    }
+
+    void nearestOneIn(int lo, int hi, float x, float y, std::pair<float, int>& best) const
+    {
+        if (hi - lo <= kLeafSize)
+        {
+            for (int i = lo; i < hi; ++i)
+            {
+                float d = squaredDistance(i, x, y);
+                if (d < best.first) best = {d, ids[i]};
+            }
+            return;
+        }
+        int mid = (lo + hi) / 2;
+        float d = squaredDistance(mid, x, y);
+        if (d < best.first) best = {d, ids[mid]};
+        float diff = splitOnY[mid] ? y - ys[mid] : x - xs[mid];
+        int nearLo = diff < 0 ? lo : mid + 1, nearHi = diff < 0 ? mid : hi;
+        int farLo = diff < 0 ? mid + 1 : lo, farHi = diff < 0 ? hi : mid;
+        nearestOneIn(nearLo, nearHi, x, y, best);
+        if (diff * diff < best.first) nearestOneIn(farLo, farHi, x, y, best);
+    }
+
+    void radiusIn(int lo, int hi, float x, float y, float radius2, int skip, std::vector<int>& out) const
+    {
+        if (hi - lo <= kLeafSize)
+        {
+            for (int i = lo; i < hi; ++i)
+                if (ids[i] != skip && squaredDistance(i, x, y) <= radius2) out.push_back(ids[i]);
+            return;
+        }
+        int mid = (lo + hi) / 2;
+        if (ids[mid] != skip && squaredDistance(mid, x, y) <= radius2) out.push_back(ids[mid]);
+        float diff = splitOnY[mid] ? y - ys[mid] : x - xs[mid];
+        if (diff < 0 || diff * diff <= radius2) radiusIn(lo, mid, x, y, radius2, skip, out);
+        if (diff >= 0 || diff * diff <= radius2) radiusIn(mid + 1, hi, x, y, radius2, skip, out);
+    }
+};
+
+// Adds one edge per (airport, neighbour) pair found by neighbours(i, out)
+// for every airport, weighted by straight-line distance, and finalizes the
+// graph. The lookups run on the pool; each worker collects its own links,
+// which are merged and deduplicated afterwards.
+template <typename Neighbours>
+void connectAirports(FlightGraph& graph, WorkStealingPool& pool, Neighbours neighbours)
+{
+    const int blockSize = 512;
+    int n = graph.airportCount();
+    int blocks = (n + blockSize - 1) / blockSize;
+
+    std::vector<std::vector<std::uint64_t>> found(pool.size());
+    pool.run(blocks, [&](int block, unsigned worker) {
+        std::vector<int> near;
+        auto& links = found[worker];
+        for (int i = block * blockSize; i < std::min(n, (block + 1) * blockSize); ++i)
+        {
+            neighbours(i, near);
+            for (int j : near)
+            {
+                int u = std::min(i, j), v = std::max(i, j);
+                links.push_back(static_cast<std::uint64_t>(u) << 32 | static_cast<std::uint32_t>(v));
+            }
+        }
+    });
+
+    std::vector<std::uint64_t> links;
+    for (auto& part : found) links.insert(links.end(), part.begin(), part.end());
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end()), links.end());
+
+    graph.reserveEdges(links.size());
+    for (std::uint64_t link : links)
+    {
+        int u = static_cast<int>(link >> 32);
+        int v = static_cast<int>(link & 0xffffffffu);
+        graph.addEdge(u, v, graph.straightLineDistance(u, v));
+    }
+    graph.finalize();
+}
+
+// Links every airport to its k nearest airports.
+inline void connectNearest(FlightGraph& graph, const KdTree& tree, int k, WorkStealingPool& pool)
+{
+    connectAirports(graph, pool, [&](int i, std::vector<int>& near) {
+        thread_local std::vector<std::pair<float, int>> candidates;
+        const auto& p = graph.airports[i].position;
+        tree.nearest(p.x, p.y, k, candidates, i);
+        near.clear();
+        for (const auto& c : candidates) near.push_back(c.second);
+    });
+}
+
+// Links every pair of airports at most radius apart.
+inline void connectWithinRadius(FlightGraph& graph, const KdTree& tree, float radius, WorkStealingPool& pool)
+{
+    connectAirports(graph, pool, [&](int i, std::vector<int>& near) {
+        const auto& p = graph.airports[i].position;
+        tree.withinRadius(p.x, p.y, radius, near, i);
+    });
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <memory>
+
+// Fixed set of workers with one task deque each. run() deals the task
+// indices out in contiguous blocks; a worker pops from the back of its own
+// deque and, once it runs dry, steals from the front of the others, so
+// uneven task costs (long vs. short searches) still balance out.
+// The calling thread takes part as worker 0.
+struct WorkStealingPool
+{
+    explicit WorkStealingPool(unsigned threads = 0)
+    {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < threads; ++i)
+            queues.push_back(std::make_unique<TaskQueue>());
+        for (unsigned i = 1; i < threads; ++i)
+            workers.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+    // Calls fn(task, worker) for every task in [0, taskCount) and returns
+    // once all of them have finished. worker is in [0, size()).
+    void run(int taskCount, const std::function<void(int, unsigned)>& fn)
+    {
+        if (taskCount <= 0) return;
+
+        unsigned n = size();
+        for (unsigned w = 0; w < n; ++w)
+        {
+            int first = static_cast<int>(static_cast<long long>(taskCount) * w / n);
+            int last = static_cast<int>(static_cast<long long>(taskCount) * (w + 1) / n);
+            std::lock_guard<std::mutex> lock(queues[w]->mutex);
+            for (int t = first; t < last; ++t)
+                queues[w]->tasks.push_back(t);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            remaining = taskCount;
+            ++generation;
+        }
+        wake.notify_all();
+
+        drain(0, fn);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        job = nullptr;
+        done.wait(lock, [this] { return remaining == 0 && activeWorkers == 0; });
+    }
+
+private:
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int, unsigned)>* job = nullptr;
+    int remaining = 0;
+    int activeWorkers = 0;
+    unsigned long long generation = 0;
+    bool stopping = false;
+
+    bool popLocal(unsigned w, int& task)
+    {
+        std::lock_guard<std::mutex> lock(queues[w]->mutex);
+        if (queues[w]->tasks.empty()) return false;
+        task = queues[w]->tasks.back();
+        queues[w]->tasks.pop_back();
+        return true;
+    }
+
+    bool steal(unsigned thief, int& task)
+    {
+        unsigned n = size();
+        for (unsigned k = 1; k < n; ++k)
+        {
+            unsigned victim = (thief + k) % n;
+            std::lock_guard<std::mutex> lock(queues[victim]->mutex);
+            if (queues[victim]->tasks.empty()) continue;
+            task = queues[victim]->tasks.front();
+            queues[victim]->tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void drain(unsigned w, const std::function<void(int, unsigned)>& fn)
+    {
+        int task;
+        int finished = 0;
+        while (popLocal(w, task) || steal(w, task))
+        {
+            fn(task, w);
+            ++finished;
+        }
+        if (finished == 0) return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        remaining -= finished;
+        if (remaining == 0) done.notify_all();
+    }
+
+    void workerLoop(unsigned w)
+    {
+        unsigned long long seen = 0;
+        for (;;)
+        {
+            const std::function<void(int, unsigned)>* fn;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || (generation != seen && job); });
+                if (stopping) return;
+                seen = generation;
+                fn = job;
+                ++activeWorkers;
+            }
+            drain(w, *fn);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --activeWorkers;
+            }
+            done.notify_all();
+        }
+    }
+};
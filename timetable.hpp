@@ -0,0 +1,283 @@
+#pragma once
+
+#include "flight_graph.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+// Scheduled flights and itinerary search with the Connection Scan
+// Algorithm (Dibbelt et al.). A timetable is one flat array of
+// connections (one flight leg each: from, to, departure, arrival) sorted
+// by departure time; a query is a single linear scan over it, which is
+// what makes CSA fast: no priority queue, and the memory access is purely
+// sequential.
+//
+// Times are minutes from midnight of the first day. Changing flights at
+// an airport takes at least its minimum connection time; the origin of a
+// journey has none.
+struct Connection
+{
+    std::int32_t from;
+    std::int32_t to;
+    std::int32_t departure;
+    std::int32_t arrival;
+};
+
+// A journey: the connections taken, in order, or none if there is none.
+struct Itinerary
+{
+    std::vector<int> legs;    // indices into Timetable::connections
+
+    bool empty() const { return legs.empty(); }
+};
+
+// One Pareto-optimal option of a profile query: leaving at departure
+// there is no way to arrive earlier than arrival, and leaving any later
+// arrives later. first is the first connection of that journey.
+struct ProfileEntry
+{
+    std::int32_t departure;
+    std::int32_t arrival;
+    int first;
+};
+
+struct ScanStats
+{
+    int scanned = 0;        // connections looked at
+    double seconds = 0.0;
+};
+
+struct Timetable
+{
+    std::vector<Connection> connections;
+    std::vector<std::int32_t> minimumConnection;    // per airport, minutes
+
+    int airportCount() const { return static_cast<int>(minimumConnection.size()); }
+    int size() const { return static_cast<int>(connections.size()); }
+
+    void reset(int airports, int minimumConnectionMinutes)
+    {
+        connections.clear();
+        minimumConnection.assign(airports, minimumConnectionMinutes);
+    }
+
+    void add(int from, int to, int departure, int arrival) { connections.push_back({from, to, departure, arrival}); }
+
+    // Sorts the connections for scanning; call after adding them.
+    void finalize()
+    {
+        std::sort(connections.begin(), connections.end(), [](const Connection& a, const Connection& b) {
+            return a.departure != b.departure ? a.departure < b.departure : a.arrival < b.arrival;
+        });
+    }
+
+    // First connection departing at or after time.
+    int firstDeparting(int time) const
+    {
+        auto it = std::lower_bound(connections.begin(), connections.end(), time,
+                                   [](const Connection& c, int t) { return c.departure < t; });
+        return static_cast<int>(it - connections.begin());
+    }
+
+    // Earliest arrival at dst leaving src no earlier than departure, or -1.
+    // The scan starts at the first connection leaving at departure and
+    // stops once connections leave after the best arrival found.
+    int earliestArrival(int src, int dst, int departure, Itinerary* itinerary = nullptr,
+                        ScanStats* stats = nullptr) const
+    {
+        auto start = std::chrono::steady_clock::now();
+        const std::int32_t kNever = std::numeric_limits<std::int32_t>::max();
+        std::vector<std::int32_t>& arrival = scratchArrival();
+        std::vector<int>& via = scratchVia();
+        arrival.assign(airportCount(), kNever);
+        via.assign(airportCount(), -1);
+        arrival[src] = departure;
+
+        int scanned = 0;
+        int k = firstDeparting(departure);
+        for (; k < size(); ++k)
+        {
+            const Connection& c = connections[k];
+            if (c.departure >= arrival[dst]) break;
+            ++scanned;
+            std::int32_t ready = arrival[c.from];
+            if (ready == kNever) continue;
+            if (c.from != src) ready += minimumConnection[c.from];
+            if (ready > c.departure || c.arrival >= arrival[c.to]) continue;
+            arrival[c.to] = c.arrival;
+            via[c.to] = k;
+        }
+
+        int result = src == dst ? departure : arrival[dst] == kNever ? -1 : arrival[dst];
+        if (itinerary)
+        {
+            itinerary->legs.clear();
+            if (result >= 0 && src != dst)
+            {
+                for (int stop = dst; stop != src; stop = connections[via[stop]].from)
+                    itinerary->legs.push_back(via[stop]);
+                std::reverse(itinerary->legs.begin(), itinerary->legs.end());
+            }
+        }
+        if (stats)
+        {
+            stats->scanned = scanned;
+            stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        return result;
+    }
+
+    // Every Pareto-optimal (departure, arrival) option from src to dst
+    // leaving within [begin, end], latest departure first. One backward
+    // scan from the last connection: each airport keeps the options it
+    // has to dst, added in decreasing departure and arrival, and a
+    // connection's arrival at dst is that of the first option leaving its
+    // destination after the minimum connection time.
+    void profile(int src, int dst, int begin, int end, std::vector<ProfileEntry>& options,
+                 ScanStats* stats = nullptr) const
+    {
+        auto start = std::chrono::steady_clock::now();
+        const std::int32_t kNever = std::numeric_limits<std::int32_t>::max();
+        std::vector<std::vector<ProfileEntry>>& profiles = scratchProfiles();
+        profiles.resize(airportCount());
+        for (std::vector<ProfileEntry>& p : profiles) p.clear();
+
+        int scanned = 0;
+        int first = firstDeparting(begin);
+        for (int k = size() - 1; k >= first; --k)
+        {
+            const Connection& c = connections[k];
+            ++scanned;
+            if (c.from == dst) continue;
+            std::int32_t reach = c.to == dst ? c.arrival : bestArrival(profiles[c.to], c.arrival + minimumConnection[c.to]);
+            if (reach == kNever) continue;
+            std::vector<ProfileEntry>& here = profiles[c.from];
+            if (!here.empty() && here.back().arrival <= reach) continue;
+            if (!here.empty() && here.back().departure == c.departure) here.back() = {c.departure, reach, k};
+            else here.push_back({c.departure, reach, k});
+        }
+
+        options.clear();
+        for (const ProfileEntry& entry : profiles[src])
+            if (entry.departure <= end) options.push_back(entry);
+        if (stats)
+        {
+            stats->scanned = scanned;
+            stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    // The journey of a profile option: from its first connection, each
+    // leg is followed by the first option at its arrival airport leaving
+    // after the minimum connection time. Valid until the next profile().
+    void profileItinerary(int dst, const ProfileEntry& option, Itinerary& itinerary) const
+    {
+        const std::vector<std::vector<ProfileEntry>>& profiles = scratchProfiles();
+        itinerary.legs.clear();
+        for (int k = option.first; k >= 0;)
+        {
+            itinerary.legs.push_back(k);
+            const Connection& c = connections[k];
+            if (c.to == dst) break;
+            k = bestOption(profiles[c.to], c.arrival + minimumConnection[c.to]);
+        }
+    }
+
+private:
+    // Per-thread search state, so queries are const and can run in
+    // parallel on one timetable.
+    static std::vector<std::int32_t>& scratchArrival()
+    {
+        static thread_local std::vector<std::int32_t> arrival;
+        return arrival;
+    }
+
+    static std::vector<int>& scratchVia()
+    {
+        static thread_local std::vector<int> via;
+        return via;
+    }
+
+    static std::vector<std::vector<ProfileEntry>>& scratchProfiles()
+    {
+        static thread_local std::vector<std::vector<ProfileEntry>> profiles;
+        return profiles;
+    }
+
+    // Options are kept latest departure first, so the ones leaving at or
+    // after time are a prefix, and the last of it arrives earliest.
+    static int optionIndex(const std::vector<ProfileEntry>& options, int time)
+    {
+        auto it = std::partition_point(options.begin(), options.end(),
+                                       [time](const ProfileEntry& e) { return e.departure >= time; });
+        return static_cast<int>(it - options.begin()) - 1;
+    }
+
+    static std::int32_t bestArrival(const std::vector<ProfileEntry>& options, int time)
+    {
+        int i = optionIndex(options, time);
+        return i < 0 ? std::numeric_limits<std::int32_t>::max() : options[i].arrival;
+    }
+
+    static int bestOption(const std::vector<ProfileEntry>& options, int time)
+    {
+        int i = optionIndex(options, time);
+        return i < 0 ? -1 : options[i].first;
+    }
+};
+
+struct ScheduleOptions
+{
+    int days = 2;                    // the daily schedule is repeated this often
+    int flightsPerLeg = 4;           // per direction and day
+    int firstDeparture = 6 * 60;     // departures spread over [first, last]
+    int lastDeparture = 22 * 60;
+    double speed = 100.0;            // map units per hour
+    int groundMinutes = 30;          // taxi, take-off and landing per flight
+    int minimumConnection = 45;
+    unsigned seed = 1;
+};
+
+// A synthetic daily schedule over the network: every edge is flown in
+// both directions flightsPerLeg times a day, at departures spread evenly
+// over the day with a random offset per edge and direction, taking
+// groundMinutes plus the distance at speed.
+inline Timetable buildTimetable(const FlightGraph& graph, const ScheduleOptions& options = ScheduleOptions())
+{
+    Timetable timetable;
+    timetable.reset(graph.airportCount(), options.minimumConnection);
+    timetable.connections.reserve(static_cast<size_t>(graph.edgeCount()) * 2 * options.flightsPerLeg * options.days);
+    std::mt19937 rng(options.seed);
+    int window = std::max(1, options.lastDeparture - options.firstDeparture);
+    int spacing = std::max(1, window / std::max(1, options.flightsPerLeg));
+    std::uniform_int_distribution<int> offset(0, spacing - 1);
+    for (int e = 0; e < graph.edgeCount(); ++e)
+    {
+        int duration = options.groundMinutes + static_cast<int>(std::lround(graph.edgeWeight[e] / options.speed * 60));
+        for (int direction = 0; direction < 2; ++direction)
+        {
+            int from = direction ? graph.edgeTo[e] : graph.edgeFrom[e];
+            int to = direction ? graph.edgeFrom[e] : graph.edgeTo[e];
+            int first = options.firstDeparture + offset(rng);
+            for (int f = 0; f < options.flightsPerLeg; ++f)
+            {
+                int departure = first + f * spacing;
+                for (int day = 0; day < options.days; ++day)
+                    timetable.add(from, to, day * 1440 + departure, day * 1440 + departure + duration);
+            }
+        }
+    }
+    timetable.finalize();
+    return timetable;
+}
+
+// "HH:MM", with "+d" for later days.
+inline std::string formatClock(int minutes)
+{
+    char text[16];
+    int day = minutes / 1440;
+    minutes %= 1440;
+    if (day > 0) std::snprintf(text, sizeof text, "%02d:%02d+%d", minutes / 60, minutes % 60, day);
+    else std::snprintf(text, sizeof text, "%02d:%02d", minutes / 60, minutes % 60);
+    return text;
+}
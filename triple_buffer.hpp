@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free handoff of the latest value from one producer thread to one
+// consumer thread. Of the three buffers the producer owns one, the
+// consumer owns one, and the third sits in between; handing over is a
+// single atomic exchange on either side, so neither side ever waits and
+// the consumer always gets the newest complete value (older unread ones
+// are overwritten, not queued).
+//
+//   producer: fill writeBuffer(), then publish()
+//   consumer: if (acquire()) use readBuffer()
+template <typename T>
+struct TripleBuffer
+{
+    T& writeBuffer() { return buffers[back]; }
+
+    void publish()
+    {
+        unsigned previous = middle.exchange(back | kFresh, std::memory_order_acq_rel);
+        back = previous & kIndex;
+    }
+
+    // Takes the most recently published value, if there is one the
+    // consumer has not seen. readBuffer() stays valid until the next call.
+    bool acquire()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & kFresh)) return false;
+        unsigned previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & kIndex;
+        return true;
+    }
+
+    const T& readBuffer() const { return buffers[front]; }
+
+private:
+    static const unsigned kIndex = 3;
+    static const unsigned kFresh = 4;
+
+    T buffers[3];
+    std::atomic<unsigned> middle{1};
+    unsigned back = 0;     // producer only
+    unsigned front = 2;    // consumer only
+};
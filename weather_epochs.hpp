@@ -0,0 +1,180 @@
+#pragma once
+
+#include "flight_graph.hpp"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+// Weather state that routing threads read while a writer keeps applying
+// updates. There are two copies of the graph's weather; both borrow the
+// topology (edges, CSR arrays) of the base graph, which must outlive them.
+//
+// Readers pin the current epoch in their own slot and search the copy that
+// belongs to it; pinning is a load, a store and a re-check, with no lock.
+// A writer edits the other copy and publishes it as the next epoch with one
+// atomic store. Before it may edit a copy again, it waits until no reader
+// is still pinned to an older epoch (the grace period), then brings the
+// copy up to date with the published one. A reader that stays pinned for
+// long therefore holds up writers, never other readers.
+struct WeatherEpochs
+{
+    static const int kMaxReaders = 64;
+
+    explicit WeatherEpochs(const FlightGraph& base)
+    {
+        for (FlightGraph& copy : copies)
+        {
+            copy.airports = base.airports;
+            // The topology arrays are only read through the copies.
+            copy.edgeFrom.borrow(const_cast<int*>(base.edgeFrom.data()), base.edgeFrom.size());
+            copy.edgeTo.borrow(const_cast<int*>(base.edgeTo.data()), base.edgeTo.size());
+            copy.edgeWeight.borrow(const_cast<double*>(base.edgeWeight.data()), base.edgeWeight.size());
+            copy.arcOffset.borrow(const_cast<int*>(base.arcOffset.data()), base.arcOffset.size());
+            copy.arcTarget.borrow(const_cast<int*>(base.arcTarget.data()), base.arcTarget.size());
+            copy.arcEdge.borrow(const_cast<int*>(base.arcEdge.data()), base.arcEdge.size());
+            copy.arcWeight.borrow(const_cast<double*>(base.arcWeight.data()), base.arcWeight.size());
+            copy.hazardBits = base.hazardBits;
+            copy.availableBits = base.availableBits;
+            copy.edgeDescription = base.edgeDescription;
+            copy.weatherDescriptions = base.weatherDescriptions;
+            copy.descriptionHazard = base.descriptionHazard;
+            copy.descriptionIndex = base.descriptionIndex;
+            copy.heuristicScale = base.heuristicScale;
+            copy.storage = base.storage;
+        }
+    }
+
+    WeatherEpochs(const WeatherEpochs&) = delete;
+    WeatherEpochs& operator=(const WeatherEpochs&) = delete;
+
+    std::uint64_t epoch() const { return current.load(); }
+
+    // Reader side. A thread takes a slot once and pins/unpins it around
+    // each query; see WeatherReader and PinnedWeather.
+    int acquireSlot()
+    {
+        for (int i = 0; i < kMaxReaders; ++i)
+        {
+            bool expected = false;
+            if (slots[i].used.compare_exchange_strong(expected, true)) return i;
+        }
+        return -1;
+    }
+
+    void releaseSlot(int slot) { slots[slot].used.store(false); }
+
+    const FlightGraph& pin(int slot, std::uint64_t& pinned)
+    {
+        std::uint64_t e = current.load();
+        for (;;)
+        {
+            slots[slot].pinned.store(e);
+            std::uint64_t again = current.load();
+            if (again == e) break;
+            e = again;
+        }
+        pinned = e;
+        return copies[e & 1];
+    }
+
+    void unpin(int slot) { slots[slot].pinned.store(kIdle); }
+
+    // Writer side. beginUpdate() waits out the grace period and returns the
+    // copy that will become the next epoch, already equal to the current
+    // one; change it with the usual FlightGraph weather calls, then
+    // publish(). Writers are serialized between the two calls.
+    FlightGraph& beginUpdate()
+    {
+        writer.lock();
+        std::uint64_t e = current.load();
+        auto start = std::chrono::steady_clock::now();
+        while (oldestPinned() < e) std::this_thread::yield();
+        lastGraceSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        FlightGraph& next = copies[(e + 1) & 1];
+        const FlightGraph& published = copies[e & 1];
+        if (staleCopy)
+        {
+            next.hazardBits = published.hazardBits;
+            next.availableBits = published.availableBits;
+            next.edgeDescription = published.edgeDescription;
+            for (size_t i = next.weatherDescriptions.size(); i < published.weatherDescriptions.size(); ++i)
+            {
+                next.weatherDescriptions.push_back(published.weatherDescriptions[i]);
+                next.descriptionHazard.push_back(published.descriptionHazard[i]);
+                next.descriptionIndex.emplace(published.weatherDescriptions[i], static_cast<std::uint32_t>(i));
+            }
+        }
+        return next;
+    }
+
+    void publish()
+    {
+        current.store(current.load() + 1);
+        staleCopy = true;
+        writer.unlock();
+    }
+
+    // How long the last beginUpdate() waited for readers, in seconds.
+    double graceSeconds() const { return lastGraceSeconds; }
+
+private:
+    static const std::uint64_t kIdle = ~std::uint64_t(0);
+
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<std::uint64_t> pinned{kIdle};
+        std::atomic<bool> used{false};
+    };
+
+    FlightGraph copies[2];
+    std::atomic<std::uint64_t> current{0};
+    ReaderSlot slots[kMaxReaders];
+    std::mutex writer;
+    bool staleCopy = false;
+    double lastGraceSeconds = 0.0;
+
+    std::uint64_t oldestPinned() const
+    {
+        std::uint64_t oldest = kIdle;
+        for (const ReaderSlot& slot : slots)
+            oldest = std::min(oldest, slot.pinned.load());
+        return oldest;
+    }
+};
+
+// A reader slot for the lifetime of the object, typically one per thread.
+struct WeatherReader
+{
+    explicit WeatherReader(WeatherEpochs& w) : epochs(w), slot(w.acquireSlot()) {}
+    ~WeatherReader()
+    {
+        if (slot >= 0) epochs.releaseSlot(slot);
+    }
+
+    WeatherReader(const WeatherReader&) = delete;
+    WeatherReader& operator=(const WeatherReader&) = delete;
+
+    bool valid() const { return slot >= 0; }
+
+    WeatherEpochs& epochs;
+    int slot;
+};
+
+// One consistent view of the weather, held for the duration of a query:
+//
+//   PinnedWeather pinned(reader);
+//   GraphView(pinned.graph).shortestPath(src, dst, path, mode);
+struct PinnedWeather
+{
+    explicit PinnedWeather(WeatherReader& r) : reader(r), graph(r.epochs.pin(r.slot, epoch)) {}
+    ~PinnedWeather() { reader.epochs.unpin(reader.slot); }
+
+    PinnedWeather(const PinnedWeather&) = delete;
+    PinnedWeather& operator=(const PinnedWeather&) = delete;
+
+    WeatherReader& reader;
+    std::uint64_t epoch;
+    const FlightGraph& graph;
+};
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "network_loader.hpp"
+#include <istream>
+#include <chrono>
+#include <cstring>
+
+// Non-interactive weather ingestion. A feed is either text, one update
+// per line:
+//
+//   <airport> <airport> <0|1> [description]    airports by index or code
+//   commit                                     ends the current epoch
+//   # comment
+//
+// or binary: the 8-byte magic "AEROWX01" followed by 12-byte little-endian
+// records { int32 a, int32 b, uint8 flags, uint8 hazard, uint16 unused },
+// where flags bit 0 means bad weather and bit 1 ends the epoch after the
+// record. Binary updates are described by their hazard name.
+//
+// Updates are grouped into epochs (at a commit, every epochSize updates
+// and at the end of the feed), coalesced per edge and applied to the graph
+// with one applyWeatherUpdates call.
+const char kWeatherFeedMagic[8] = {'A', 'E', 'R', 'O', 'W', 'X', '0', '1'};
+
+struct WeatherFeedRecord
+{
+    std::int32_t a;
+    std::int32_t b;
+    std::uint8_t flags;
+    std::uint8_t hazard;
+    std::uint16_t unused;
+};
+
+struct WeatherEpochStats
+{
+    int epoch = 0;
+    int received = 0;
+    int applied = 0;
+    int rejected = 0;
+    int changed = 0;
+    double parseSeconds = 0.0;
+    double applySeconds = 0.0;
+
+    double updatesPerSecond() const
+    {
+        double total = parseSeconds + applySeconds;
+        return total > 0.0 ? received / total : 0.0;
+    }
+};
+
+struct WeatherFeedReader
+{
+    WeatherFeedReader(std::istream& input, FlightGraph& g, int updatesPerEpoch = 4096)
+        : in(input), graph(g), airports(g), epochSize(updatesPerEpoch)
+    {
+        slotOfEdge.assign(graph.edgeCount(), -1);
+
+        // Pipes cannot seek back, so the bytes matched while looking for the
+        // magic are kept as the start of the first text line.
+        for (char c : kWeatherFeedMagic)
+        {
+            if (in.peek() != c) break;
+            prefix += static_cast<char>(in.get());
+        }
+        binary = prefix.size() == sizeof kWeatherFeedMagic;
+    }
+
+    // Reads and applies the next epoch. Returns false once the feed is
+    // exhausted and nothing was read. changed receives the edges whose
+    // availability flipped.
+    bool nextEpoch(WeatherEpochStats& stats, std::vector<int>& changed)
+    {
+        auto start = std::chrono::steady_clock::now();
+        stats = WeatherEpochStats();
+        stats.epoch = epochCount + 1;
+        changed.clear();
+
+        bool more = binary ? readBinary(stats) : readText(stats);
+        if (stats.received == 0 && !more) return false;
+        ++epochCount;
+
+        updates.clear();
+        for (const PendingEdge& pending : pendingEdges)
+        {
+            if (pending.clear) updates.push_back({pending.edge, false, 0});
+            for (int h = 0; h < kHazardCount; ++h)
+                if (h != pending.lastHazard && pending.description[h])
+                    updates.push_back({pending.edge, true, pending.description[h]});
+            if (pending.lastHazard >= 0)
+                updates.push_back({pending.edge, true, pending.description[pending.lastHazard]});
+            slotOfEdge[pending.edge] = -1;
+        }
+        pendingEdges.clear();
+        stats.applied = static_cast<int>(updates.size());
+
+        auto applyStart = std::chrono::steady_clock::now();
+        stats.parseSeconds = std::chrono::duration<double>(applyStart - start).count();
+        graph.applyWeatherUpdates(updates, &changed);
+        stats.applySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - applyStart).count();
+        stats.changed = static_cast<int>(changed.size());
+        return true;
+    }
+
+    int epochs() const { return epochCount; }
+
+private:
+    // What an epoch does to one edge: an optional clear, then the latest
+    // description per hazard (0 = none), the last one given applied last.
+    struct PendingEdge
+    {
+        int edge;
+        bool clear;
+        int lastHazard;
+        std::uint32_t description[kHazardCount];
+    };
+
+    std::istream& in;
+    FlightGraph& graph;
+    AirportLookup airports;
+    int epochSize;
+    bool binary = false;
+    int epochCount = 0;
+    std::vector<int> slotOfEdge;
+    std::vector<PendingEdge> pendingEdges;
+    std::vector<WeatherUpdate> updates;
+    std::string line;
+    std::string prefix;
+
+    bool add(int a, int b, bool isBad, std::uint32_t description)
+    {
+        if (a < 0 || b < 0) return false;
+        int e = graph.findEdge(a, b);
+        if (e < 0) return false;
+
+        int& slot = slotOfEdge[e];
+        if (slot < 0)
+        {
+            slot = static_cast<int>(pendingEdges.size());
+            pendingEdges.push_back({e, false, -1, {}});
+        }
+        PendingEdge& pending = pendingEdges[slot];
+        if (!isBad)
+        {
+            pending = {e, true, -1, {}};
+            return true;
+        }
+        int h = static_cast<int>(graph.descriptionHazard[description]);
+        pending.description[h] = description;
+        pending.lastHazard = h;
+        return true;
+    }
+
+    bool readText(WeatherEpochStats& stats)
+    {
+        while (stats.received < epochSize && std::getline(in, line))
+        {
+            if (!prefix.empty())
+            {
+                line.insert(0, prefix);
+                prefix.clear();
+            }
+            std::string_view rest(line);
+            std::string_view first = nextToken(rest);
+            if (first.empty() || first[0] == '#') continue;
+            if (first == "commit") return true;
+
+            ++stats.received;
+            std::string_view second = nextToken(rest), flag = nextToken(rest);
+            if (flag != "0" && flag != "1")
+            {
+                ++stats.rejected;
+                continue;
+            }
+            bool isBad = flag == "1";
+            std::uint32_t description = 0;
+            if (isBad)
+            {
+                size_t begin = rest.find_first_not_of(" \t");
+                size_t end = rest.find_last_not_of(" \t\r");
+                description = graph.internDescription(begin == std::string_view::npos ? std::string_view("Bad weather")
+                                                                                      : rest.substr(begin, end - begin + 1));
+            }
+            if (!add(airports.find(first), airports.find(second), isBad, description)) ++stats.rejected;
+        }
+        return static_cast<bool>(in);
+    }
+
+    bool readBinary(WeatherEpochStats& stats)
+    {
+        WeatherFeedRecord record;
+        while (stats.received < epochSize && in.read(reinterpret_cast<char*>(&record), sizeof record))
+        {
+            ++stats.received;
+            bool isBad = record.flags & 1;
+            std::uint32_t description = 0;
+            if (isBad)
+            {
+                Hazard hazard = record.hazard < kHazardCount ? static_cast<Hazard>(record.hazard) : Hazard::Other;
+                description = graph.internDescription(hazardName(hazard));
+            }
+            int a = record.a >= 0 && record.a < graph.airportCount() ? record.a : -1;
+            int b = record.b >= 0 && record.b < graph.airportCount() ? record.b : -1;
+            if (!add(a, b, isBad, description)) ++stats.rejected;
+            if (record.flags & 2) return true;
+        }
+        return static_cast<bool>(in);
+    }
+};
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <cctype>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Kinds of weather hazard. Each has its own bit layer over the edges; an
+// edge is available when no layer has its bit set.
+enum class Hazard : std::uint8_t
+{
+    Storm,
+    Ice,
+    Fog,
+    Wind,
+    Closure,
+    Other
+};
+
+const int kHazardCount = 6;
+
+inline const char* hazardName(Hazard hazard)
+{
+    switch (hazard)
+    {
+        case Hazard::Storm: return "Storm";
+        case Hazard::Ice: return "Ice";
+        case Hazard::Fog: return "Fog";
+        case Hazard::Wind: return "Wind";
+        case Hazard::Closure: return "Closure";
+        default: return "Other";
+    }
+}
+
+inline bool parseHazard(const std::string& name, Hazard& hazard)
+{
+    for (int h = 0; h < kHazardCount; ++h)
+    {
+        std::string candidate = hazardName(static_cast<Hazard>(h));
+        if (name.size() == candidate.size() &&
+            std::equal(name.begin(), name.end(), candidate.begin(), [](char a, char b) {
+                return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+            }))
+        {
+            hazard = static_cast<Hazard>(h);
+            return true;
+        }
+    }
+    return false;
+}
+
+// The layer a single lower-case word points to. Words match by prefix
+// ("freezing", "closed"), short ones whole ("ice", "ash"), and "storm" and
+// "wind" anywhere in a compound ("thunderstorm", "crosswinds").
+inline Hazard classifyHazardWord(const std::string& word)
+{
+    auto starts = [&](const char* prefix) { return word.compare(0, std::char_traits<char>::length(prefix), prefix) == 0; };
+
+    if (word.find("storm") != std::string::npos || starts("thunder") || starts("lightning") || starts("hurricane") ||
+        starts("cyclone"))
+        return Hazard::Storm;
+    if (word == "ice" || word == "iced" || starts("icing") || starts("icy") || starts("snow") || starts("freez") ||
+        starts("sleet") || starts("blizzard"))
+        return Hazard::Ice;
+    if (starts("fog") || starts("mist") || starts("haze") || starts("hazy") || starts("visib")) return Hazard::Fog;
+    if (word.find("wind") != std::string::npos || starts("gust") || starts("turbul") || starts("shear"))
+        return Hazard::Wind;
+    if (starts("clos") || starts("volcan") || word == "ash" || starts("ashfall") || starts("restrict"))
+        return Hazard::Closure;
+    return Hazard::Other;
+}
+
+// Picks the layer for a free-text description such as "Thunderstorm",
+// going by its words (split on anything but letters) so that e.g.
+// "Service disruption" or "Flash flooding" are not taken for ice or ash.
+// When words point to several layers the first in Hazard order wins.
+inline Hazard classifyHazard(const std::string& description)
+{
+    Hazard hazard = Hazard::Other;
+    std::string word;
+    for (size_t i = 0; i <= description.size(); ++i)
+    {
+        unsigned char c = i < description.size() ? static_cast<unsigned char>(description[i]) : ' ';
+        if (std::isalpha(c))
+        {
+            word += static_cast<char>(std::tolower(c));
+            continue;
+        }
+        if (!word.empty()) hazard = std::min(hazard, classifyHazardWord(word));
+        word.clear();
+    }
+    return hazard;
+}
+
+inline size_t edgeWords(int edgeCount)
+{
+    return (static_cast<size_t>(edgeCount) + 63) / 64;
+}
+
+// Bits of the last word that belong to real edges.
+inline std::uint64_t edgeTailMask(int edgeCount)
+{
+    int used = edgeCount & 63;
+    return used == 0 ? ~std::uint64_t(0) : (std::uint64_t(1) << used) - 1;
+}
+
+inline int lowestSetBit(std::uint64_t word)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int b = 0;
+    while (!(word & 1)) { word >>= 1; ++b; }
+    return b;
+#endif
+}
+
+// One bit per edge, e.g. the edges named in a weather bulletin.
+struct EdgeMask
+{
+    std::vector<std::uint64_t> words;
+
+    explicit EdgeMask(int edgeCount = 0) : words(edgeWords(edgeCount), 0) {}
+
+    void set(int e) { words[e >> 6] |= std::uint64_t(1) << (e & 63); }
+    void reset(int e) { words[e >> 6] &= ~(std::uint64_t(1) << (e & 63)); }
+    bool test(int e) const { return words[e >> 6] >> (e & 63) & 1; }
+};
+
+// available[w] = ~(layer 0 | layer 1 | ...)[w] for w in [first, last).
+// layers holds layerCount layers of stride words each.
+inline void combineHazardLayers(const std::uint64_t* layers, size_t stride, int layerCount,
+                                std::uint64_t* available, size_t first, size_t last)
+{
+    size_t w = first;
+#if defined(__AVX2__)
+    const __m256i ones = _mm256_set1_epi32(-1);
+    for (; w + 4 <= last; w += 4)
+    {
+        __m256i bad = _mm256_setzero_si256();
+        for (int l = 0; l < layerCount; ++l)
+            bad = _mm256_or_si256(bad, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(layers + l * stride + w)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(available + w), _mm256_andnot_si256(bad, ones));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128i ones = _mm_set1_epi32(-1);
+    for (; w + 2 <= last; w += 2)
+    {
+        __m128i bad = _mm_setzero_si128();
+        for (int l = 0; l < layerCount; ++l)
+            bad = _mm_or_si128(bad, _mm_loadu_si128(reinterpret_cast<const __m128i*>(layers + l * stride + w)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(available + w), _mm_andnot_si128(bad, ones));
+    }
+#endif
+    for (; w < last; ++w)
+    {
+        std::uint64_t bad = 0;
+        for (int l = 0; l < layerCount; ++l) bad |= layers[l * stride + w];
+        available[w] = ~bad;
+    }
+}
+
+// True if any listed edge has its bit clear in available. The bits are
+// gathered and OR-ed without a branch per edge.
+inline bool anyEdgeUnavailable(const std::uint64_t* available, const int* edges, size_t count)
+{
+    std::uint64_t missing = 0;
+    for (size_t i = 0; i < count; ++i)
+        missing |= ~(available[edges[i] >> 6] >> (edges[i] & 63));
+    return missing & 1;
+}
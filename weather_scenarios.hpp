@@ -0,0 +1,334 @@
+#pragma once
+
+#include "route_batch.hpp"
+#include <istream>
+#include <ostream>
+
+// Monte Carlo estimate of route reliability under uncertain weather. Every
+// edge fails (turns unavailable) independently with its own probability;
+// a scenario is one draw of all edges on top of the graph's current
+// weather. For each origin-destination pair the route in today's weather
+// is the baseline, and in each scenario the pair is either unaffected, or
+// blocked (the baseline crosses a failed edge) and then rerouted with some
+// detour or left without a path.
+//
+// A scenario is a GraphView over the shared graph whose availability bits
+// are a per-thread copy of today's with the failed edges cleared, so
+// setting one up costs O(failed edges) and no copy of the graph, and
+// routing on it is as fast as on the graph itself. Scenarios run in
+// parallel on a thread pool.
+// Scenario s draws from its own random stream, derived from the seed and
+// s alone, so results do not depend on the thread count or on which
+// thread ran which scenario.
+
+// SplitMix64: a small, fast generator whose streams for different seeds
+// are independent enough for sampling.
+struct ScenarioRandom
+{
+    std::uint64_t state;
+
+    ScenarioRandom(std::uint64_t seed, std::uint64_t stream) : state(seed)
+    {
+        state = next() ^ (stream * 0xD1B54A32D192ED03ull);
+    }
+
+    std::uint64_t next()
+    {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+};
+
+// Per-edge failure probabilities. compile() (after any change to
+// probability) keeps a compact list of the edges that can fail, and an
+// edge fails when a 64-bit draw is below its threshold.
+struct FailureModel
+{
+    std::vector<float> probability;          // per edge
+    std::vector<int> edges;                  // ascending
+    std::vector<std::uint64_t> thresholds;
+
+    explicit FailureModel(const FlightGraph& graph, double p = 0.0)
+        : probability(graph.edgeCount(), static_cast<float>(p))
+    {
+        compile();
+    }
+
+    // Appends the failed edges of one scenario, in ascending order.
+    void sample(ScenarioRandom& rng, std::vector<int>& failed) const
+    {
+        for (size_t k = 0; k < edges.size(); ++k)
+            if (rng.next() < thresholds[k]) failed.push_back(edges[k]);
+    }
+
+    void compile()
+    {
+        edges.clear();
+        thresholds.clear();
+        for (int e = 0; e < static_cast<int>(probability.size()); ++e)
+        {
+            double p = std::min(1.0, std::max(0.0, double(probability[e])));
+            if (p <= 0.0) continue;
+            edges.push_back(e);
+            thresholds.push_back(p >= 1.0 ? ~std::uint64_t(0) : static_cast<std::uint64_t>(p * 18446744073709551616.0));
+        }
+    }
+};
+
+// Reads failure probabilities, one edge per line,
+//
+//   <airport> <airport> <probability>      airports by index or code
+//   # comment
+//
+// Returns false, with the line number in error, on a malformed line or an
+// unknown airport or leg.
+inline bool readFailureProbabilities(std::istream& in, const FlightGraph& graph, FailureModel& model,
+                                     std::string& error)
+{
+    AirportLookup airports(graph);
+    std::vector<std::pair<int, double>> entries;
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number)
+    {
+        std::string_view rest(line);
+        std::string_view first = nextToken(rest);
+        if (first.empty() || first[0] == '#') continue;
+        int u = airports.find(first), v = airports.find(nextToken(rest));
+        double p;
+        if (u < 0 || v < 0 || !parseCsvDouble(nextToken(rest), p) || p < 0.0 || p > 1.0)
+        {
+            error = "line " + std::to_string(number) + ": expected <airport> <airport> <probability 0..1>";
+            return false;
+        }
+        int e = graph.findEdge(u, v);
+        if (e < 0)
+        {
+            error = "line " + std::to_string(number) + ": no leg between those airports";
+            return false;
+        }
+        entries.push_back({e, p});
+    }
+    for (const auto& entry : entries) model.probability[entry.first] = static_cast<float>(entry.second);
+    model.compile();
+    return true;
+}
+
+struct ScenarioOptions
+{
+    int scenarios = 1000;
+    std::uint64_t seed = 1;
+    SearchMode mode = SearchMode::AStar;
+    unsigned threads = 0;
+};
+
+// What happened to one origin-destination pair across all scenarios.
+struct PairReliability
+{
+    int src = -1;
+    int dst = -1;
+    double distance = -1.0;       // baseline, -1 if there is none even today
+    int scenarios = 0;
+    int blocked = 0;
+    int rerouted = 0;
+    int unreachable = 0;          // blocked without a detour, or no baseline
+    std::vector<float> detours;   // extra distance per reroute, ascending
+
+    double rate(int count) const { return scenarios > 0 ? double(count) / scenarios : 0.0; }
+
+    double meanDetour() const
+    {
+        double total = 0.0;
+        for (float d : detours) total += d;
+        return detours.empty() ? 0.0 : total / detours.size();
+    }
+
+    // The q-quantile (nearest rank) of the detours, 0 without reroutes.
+    double detourQuantile(double q) const
+    {
+        if (detours.empty()) return 0.0;
+        size_t rank = static_cast<size_t>(std::ceil(q * detours.size()));
+        return detours[std::min(detours.size() - 1, rank > 0 ? rank - 1 : 0)];
+    }
+};
+
+struct ScenarioStats
+{
+    int scenarios = 0;
+    long long failedEdges = 0;
+    long long searches = 0;
+    unsigned threads = 0;
+    double seconds = 0.0;
+
+    double scenariosPerSecond() const { return seconds > 0.0 ? scenarios / seconds : 0.0; }
+};
+
+// Fills in pairs (src and dst set by the caller) over options.scenarios
+// scenarios.
+inline void analyseWeatherScenarios(const FlightGraph& graph, const FailureModel& model,
+                                    std::vector<PairReliability>& pairs, const ScenarioOptions& options,
+                                    ScenarioStats* stats = nullptr)
+{
+    ScenarioStats local;
+    ScenarioStats& st = stats ? *stats : local;
+    st = ScenarioStats();
+    auto start = std::chrono::steady_clock::now();
+
+    // Baselines, and their edges flattened: pair i owns
+    // [edgeFirst[i], edgeFirst[i + 1]).
+    GraphView today(graph);
+    std::vector<int> path, edges, baselineEdges, edgeFirst{0};
+    SearchStats searchStats;
+    for (PairReliability& pair : pairs)
+    {
+        pair.scenarios = options.scenarios;
+        pair.blocked = pair.rerouted = pair.unreachable = 0;
+        pair.detours.clear();
+        today.shortestPath(pair.src, pair.dst, path, options.mode, &searchStats);
+        pair.distance = path.empty() ? -1.0 : searchStats.distance;
+        if (path.empty()) pair.unreachable = pair.scenarios;
+        graph.pathEdges(path, edges);
+        baselineEdges.insert(baselineEdges.end(), edges.begin(), edges.end());
+        edgeFirst.push_back(static_cast<int>(baselineEdges.size()));
+    }
+
+    struct WorkerResults
+    {
+        GraphView view;
+        std::vector<std::uint64_t> available;
+        std::vector<int> failed;
+        std::vector<int> path;
+        std::vector<int> blocked;
+        std::vector<int> unreachable;
+        std::vector<std::vector<float>> detours;
+        long long failedEdges = 0;
+        long long searches = 0;
+
+        explicit WorkerResults(const FlightGraph& graph) : view(graph) {}
+    };
+
+    WorkStealingPool pool(options.threads);
+    std::vector<WorkerResults> workers(pool.size(), WorkerResults(graph));
+    for (WorkerResults& w : workers)
+    {
+        w.blocked.assign(pairs.size(), 0);
+        w.unreachable.assign(pairs.size(), 0);
+        w.detours.resize(pairs.size());
+        w.available.assign(graph.availableBits.begin(), graph.availableBits.end());
+        w.view.availableBits = w.available.data();
+    }
+
+    pool.run(options.scenarios, [&](int scenario, unsigned worker) {
+        WorkerResults& w = workers[worker];
+        ScenarioRandom rng(options.seed, static_cast<std::uint64_t>(scenario));
+        // Put back the edges the thread's last scenario failed.
+        for (int e : w.failed) w.available[e >> 6] = graph.availableBits[e >> 6];
+        w.failed.clear();
+        model.sample(rng, w.failed);
+        w.failedEdges += w.failed.size();
+        for (int e : w.failed) w.available[e >> 6] &= ~(std::uint64_t(1) << (e & 63));
+
+        SearchStats routeStats;
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            const PairReliability& pair = pairs[i];
+            if (pair.distance < 0.0) continue;
+            bool blocked = false;
+            for (int k = edgeFirst[i]; k < edgeFirst[i + 1] && !blocked; ++k)
+                blocked = std::binary_search(w.failed.begin(), w.failed.end(), baselineEdges[k]);
+            if (!blocked) continue;
+
+            ++w.blocked[i];
+            ++w.searches;
+            w.view.shortestPath(pair.src, pair.dst, w.path, options.mode, &routeStats);
+            if (w.path.empty()) ++w.unreachable[i];
+            else w.detours[i].push_back(static_cast<float>(routeStats.distance - pair.distance));
+        }
+    });
+
+    for (WorkerResults& w : workers)
+    {
+        st.failedEdges += w.failedEdges;
+        st.searches += w.searches;
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            pairs[i].blocked += w.blocked[i];
+            pairs[i].unreachable += w.unreachable[i];
+            pairs[i].detours.insert(pairs[i].detours.end(), w.detours[i].begin(), w.detours[i].end());
+        }
+    }
+    for (PairReliability& pair : pairs)
+    {
+        std::sort(pair.detours.begin(), pair.detours.end());
+        pair.rerouted = static_cast<int>(pair.detours.size());
+    }
+
+    st.scenarios = options.scenarios;
+    st.threads = pool.size();
+    st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Appends the JSON line (with its '\n') for a pair: the baseline, the
+// fraction of scenarios in which it was blocked, rerouted and left
+// without a path, and the detour distribution over the reroutes.
+//
+//   {"src":"JFK","dst":"MIA","found":true,"distance":460.977,"scenarios":1000,
+//    "blocked":0.084,"rerouted":0.081,"unreachable":0.003,
+//    "detour":{"mean":37.2,"p50":21.5,"p90":88.0,"p99":140.3,"max":151.9}}
+inline void appendReliabilityJson(std::string& out, const FlightGraph& graph, const PairReliability& pair)
+{
+    char number[64];
+    out += "{\"src\":";
+    appendJsonString(out, graph.airports[pair.src].code);
+    out += ",\"dst\":";
+    appendJsonString(out, graph.airports[pair.dst].code);
+    out += pair.distance >= 0.0 ? ",\"found\":true" : ",\"found\":false";
+    if (pair.distance >= 0.0)
+    {
+        std::snprintf(number, sizeof number, "%.3f", pair.distance);
+        out += ",\"distance\":";
+        out += number;
+    }
+    std::snprintf(number, sizeof number, ",\"scenarios\":%d", pair.scenarios);
+    out += number;
+    std::snprintf(number, sizeof number, ",\"blocked\":%.4f", pair.rate(pair.blocked));
+    out += number;
+    std::snprintf(number, sizeof number, ",\"rerouted\":%.4f", pair.rate(pair.rerouted));
+    out += number;
+    std::snprintf(number, sizeof number, ",\"unreachable\":%.4f", pair.rate(pair.unreachable));
+    out += number;
+    std::snprintf(number, sizeof number, ",\"detour\":{\"mean\":%.3f", pair.meanDetour());
+    out += number;
+    std::snprintf(number, sizeof number, ",\"p50\":%.3f", pair.detourQuantile(0.5));
+    out += number;
+    std::snprintf(number, sizeof number, ",\"p90\":%.3f", pair.detourQuantile(0.9));
+    out += number;
+    std::snprintf(number, sizeof number, ",\"p99\":%.3f", pair.detourQuantile(0.99));
+    out += number;
+    std::snprintf(number, sizeof number, ",\"max\":%.3f}}\n", pair.detours.empty() ? 0.0 : double(pair.detours.back()));
+    out += number;
+}
+
+// Batch mode for reliability: analyses the routes between endpoints over
+// options.scenarios scenarios of model and writes one
+// appendReliabilityJson line per pair to out, in order. Returns false if
+// out fails.
+inline bool runScenarioBatch(const FlightGraph& graph, const FailureModel& model,
+                             const std::vector<std::pair<int, int>>& endpoints, std::ostream& out,
+                             const ScenarioOptions& options, ScenarioStats* stats = nullptr)
+{
+    std::vector<PairReliability> pairs(endpoints.size());
+    for (size_t k = 0; k < pairs.size(); ++k)
+    {
+        pairs[k].src = endpoints[k].first;
+        pairs[k].dst = endpoints[k].second;
+    }
+    analyseWeatherScenarios(graph, model, pairs, options, stats);
+
+    std::string buffer;
+    for (const PairReliability& pair : pairs) appendReliabilityJson(buffer, graph, pair);
+    out.write(buffer.data(), buffer.size());
+    out.flush();
+    return static_cast<bool>(out);
+}